@@ -6,6 +6,8 @@
 
 #include "Application.h"
 
+int nodeCount = 0;
+
 void handler(int sig) {
 	void *array[10];
 	size_t size;
@@ -19,6 +21,7 @@ void handler(int sig) {
 	exit(1);
 }
 
+#ifndef BENCHMARK
 /**********************************
  * FUNCTION NAME: main
  *
@@ -40,6 +43,7 @@ int main(int argc, char *argv[]) {
 
 	return SUCCESS;
 }
+#endif /* BENCHMARK */
 
 /**
  * Constructor of the Application class
@@ -51,6 +55,7 @@ Application::Application(char *infile) {
 	par->setparams(infile);
 	log = new Log(par);
 	en = new EmulNet(par);
+	runningTime = TOTAL_RUNNING_TIME;
 	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
 
 	/*
@@ -96,7 +101,7 @@ int Application::run()
 	srand(time(NULL));
 
 	// As time runs along
-	for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
+	for( par->globaltime = 0; par->globaltime < runningTime; ++par->globaltime ) {
 		// Run the membership protocol
 		mp1Run();
 		// Fail some nodes
@@ -104,12 +109,12 @@ int Application::run()
 	}
 
 	// Clean up
-	en->ENcleanup();
-
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
 		 mp1[i]->finishUpThisNode();
 	}
 
+	en->ENcleanup();
+
 	return SUCCESS;
 }
 
@@ -183,7 +188,7 @@ void Application::fail() {
 		#ifdef DEBUGLOG
 		log->LOG(&mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
 		#endif
-		mp1[removed]->getMemberNode()->bFailed = true;
+		stopNode(removed);
 	}
 	else if( par->getcurrtime() == 100 ) {
 		removed = rand() % par->EN_GPSZ/2;
@@ -191,7 +196,7 @@ void Application::fail() {
 			#ifdef DEBUGLOG
 			log->LOG(&mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
 			#endif
-			mp1[i]->getMemberNode()->bFailed = true;
+			stopNode(i);
 		}
 	}
 
@@ -201,6 +206,19 @@ void Application::fail() {
 
 }
 
+/**
+ * FUNCTION NAME: stopNode
+ *
+ * DESCRIPTION: Take node i down. It crashes, unless GRACEFUL_LEAVE is set: then it
+ * 				leaves the group first.
+ */
+void Application::stopNode(int i) {
+	if ( par->GRACEFUL_LEAVE ) {
+		mp1[i]->finishUpThisNode();
+	}
+	mp1[i]->getMemberNode()->bFailed = true;
+}
+
 /**
  * FUNCTION NAME: getjoinaddr
  *
@@ -210,7 +228,7 @@ Address Application::getjoinaddr(void){
 	//trace.funcEntry("Application::getjoinaddr");
     Address joinaddr;
     joinaddr.init();
-    *(int *)(&(joinaddr.addr))=1;
+    *(int *)(&(joinaddr.addr))=par->SEEDS[0];
     *(short *)(&(joinaddr.addr[4]))=0;
     //trace.funcExit("Application::getjoinaddr", SUCCESS);
     return joinaddr;
@@ -18,7 +18,7 @@
 /**
  * global variables
  */
-int nodeCount = 0;
+extern int nodeCount;
 
 /*
  * Macros
@@ -32,7 +32,7 @@ int nodeCount = 0;
  * DESCRIPTION: Application layer of the distributed system
  */
 class Application{
-private:
+protected:
 	// Address for introduction to the group
 	// Coordinator Node
 	char JOINADDR[30];
@@ -40,13 +40,15 @@ private:
     Log *log;
 	MP1Node **mp1;
 	Params *par;
+	int runningTime;
 public:
 	Application(char *);
 	virtual ~Application();
 	Address getjoinaddr();
 	int run();
 	void mp1Run();
-	void fail();
+	virtual void fail();
+	void stopNode(int i);
 };
 
 #endif /* _APPLICATION_H__ */
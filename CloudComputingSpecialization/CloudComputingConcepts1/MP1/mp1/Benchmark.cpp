@@ -0,0 +1,381 @@
+/**********************************
+ * FILE NAME: Benchmark.cpp
+ *
+ * DESCRIPTION: Membership protocol benchmark driver. Sweeps cluster size,
+ * 				message drop rate and failure pattern and prints one JSON
+ * 				object per run.
+ *
+ * 				Usage: ./Benchmark testcases/bench.conf > results.json
+ *
+ * 				The sweep file lists comma separated values:
+ * 					SIZES: 10,100,1000
+ * 					DROP_RATES: 0,0.1
+ * 					FAILURES: none,single,multi,random
+ * 					RUN_TIME: 300
+ * 					FAIL_TIME: 0
+ * 				FAIL_TIME 0 fails nodes BENCH_FAIL_DELAY ticks after the last
+ * 				one joined. Any other line (PARTIAL_VIEW, SEEDS, ...) is passed
+ * 				on to every run as an optional setting.
+ **********************************/
+
+#include "Benchmark.h"
+
+static const char *failureNames[] = {"none", "single", "multi", "random"};
+
+/**
+ * Constructor
+ */
+Benchmark::Benchmark(char *infile, FailurePattern failure, int runTime, int failTime): Application(infile) {
+	int n = par->EN_GPSZ;
+
+	this->failure = failure;
+	this->runningTime = runTime;
+	this->joinEnd = (int)(par->STEP_RATE * (n - 1));
+	this->failTime = failTime > 0 ? failTime : joinEnd + BENCH_FAIL_DELAY;
+	known.assign(n, vector<bool>(n, false));
+	knownCount.assign(n, 0);
+	failedAt.assign(n, -1);
+	observed.assign(n, vector<bool>(n, false));
+	falselyRemoved.assign(n, vector<bool>(n, false));
+	observedPairs = falsePairs = 0;
+	falseRemovals = 0;
+	convergedAt = -1;
+	msgs = bytes = nodeTicks = 0;
+	steadyMsgs = steadyBytes = steadyNodeTicks = 0;
+
+	log->setQuiet(true);
+	log->setObserver(this);
+}
+
+/**
+ * FUNCTION NAME: index
+ *
+ * DESCRIPTION: Returns the index in mp1 of the node at addr
+ */
+int Benchmark::index(Address *addr) {
+	int i = *(int *)(addr->addr) - 1;
+	return (i >= 0 && i < par->EN_GPSZ) ? i : -1;
+}
+
+/**
+ * FUNCTION NAME: isUp
+ *
+ * DESCRIPTION: Returns true if node i was introduced and has not failed
+ */
+bool Benchmark::isUp(int i) {
+	Member *memberNode = mp1[i]->getMemberNode();
+	return memberNode->inited && !memberNode->bFailed;
+}
+
+/**
+ * FUNCTION NAME: nodeAdded
+ *
+ * DESCRIPTION: Log observer: thisNode added addedAddr to its membership list
+ */
+void Benchmark::nodeAdded(Address *thisNode, Address *addedAddr) {
+	int i = index(thisNode);
+	int j = index(addedAddr);
+	if ( i == -1 || j == -1 || i == j || known[i][j] ) {
+		return;
+	}
+	known[i][j] = true;
+	knownCount[i]++;
+
+	if ( failedAt[j] < 0 && !observed[i][j] ) {
+		observed[i][j] = true;
+		observedPairs++;
+	}
+}
+
+/**
+ * FUNCTION NAME: nodeRemoved
+ *
+ * DESCRIPTION: Log observer: thisNode removed removedAddr from its membership list.
+ * 				The first removal of a failed node is a detection, the removal of
+ * 				a live one is a false positive.
+ */
+void Benchmark::nodeRemoved(Address *thisNode, Address *removedAddr) {
+	int i = index(thisNode);
+	int j = index(removedAddr);
+	if ( i == -1 || j == -1 || i == j || !known[i][j] ) {
+		return;
+	}
+	known[i][j] = false;
+	knownCount[i]--;
+
+	if ( failedAt[j] >= 0 ) {
+		latencies.push_back(par->getcurrtime() - failedAt[j]);
+	}
+	else {
+		falseRemovals++;
+		if ( !falselyRemoved[i][j] ) {
+			falselyRemoved[i][j] = true;
+			falsePairs++;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: failNodes
+ *
+ * DESCRIPTION: Fail the nodes selected by the failure pattern
+ */
+void Benchmark::failNodes() {
+	int n = par->EN_GPSZ;
+	vector<int> victims;
+
+	switch ( failure ) {
+		case FAIL_SINGLE:
+			victims.push_back(rand() % n);
+			break;
+
+		case FAIL_MULTI: {
+			// half of the group, contiguous, like Application::fail
+			int removed = rand() % n / 2;
+			for ( int i = removed; i < removed + n / 2; i++ ) {
+				victims.push_back(i);
+			}
+			break;
+		}
+
+		case FAIL_RANDOM: {
+			vector<int> pool(n);
+			for ( int i = 0; i < n; i++ ) {
+				pool[i] = i;
+			}
+			int count = max(1, (int)(n * BENCH_RANDOM_FAILURES));
+			for ( int i = 0; i < count; i++ ) {
+				int pick = i + rand() % (n - i);
+				swap(pool[i], pool[pick]);
+				victims.push_back(pool[i]);
+			}
+			break;
+		}
+
+		case FAIL_NONE:
+		default:
+			break;
+	}
+
+	for ( int i : victims ) {
+		failedAt[i] = par->getcurrtime();
+		stopNode(i);
+	}
+}
+
+/**
+ * FUNCTION NAME: sample
+ *
+ * DESCRIPTION: Account the traffic of this tick and check for join convergence
+ */
+void Benchmark::sample() {
+	int currenttime = par->getcurrtime();
+	int n = par->EN_GPSZ;
+	int live = 0;
+	bool converged = currenttime >= joinEnd;
+
+	for ( int i = 0; i < n; i++ ) {
+		if ( isUp(i) ) {
+			live++;
+			converged = converged && knownCount[i] == n - 1;
+		}
+	}
+
+	msgs += en->getSentMsgs(currenttime);
+	bytes += en->getSentBytes(currenttime);
+	nodeTicks += live;
+
+	if ( convergedAt == -1 && converged && live == n ) {
+		convergedAt = currenttime;
+	}
+
+	// Steady state: the group has converged and nothing has failed yet
+	if ( convergedAt != -1 && currenttime < failTime ) {
+		steadyMsgs += en->getSentMsgs(currenttime);
+		steadyBytes += en->getSentBytes(currenttime);
+		steadyNodeTicks += live;
+	}
+}
+
+/**
+ * FUNCTION NAME: fail
+ *
+ * DESCRIPTION: Called once per tick by run: measure, then drop messages once all
+ * 				nodes are introduced and fail nodes at failTime
+ */
+void Benchmark::fail() {
+	sample();
+
+	if ( par->DROP_MSG && par->getcurrtime() == joinEnd ) {
+		par->dropmsg = 1;
+	}
+
+	if ( par->getcurrtime() == failTime ) {
+		failNodes();
+	}
+}
+
+/**
+ * FUNCTION NAME: percentile
+ *
+ * DESCRIPTION: Returns the p-th percentile of sorted samples (nearest rank)
+ */
+static int percentile(const vector<int> &sorted, double p) {
+	int rank = (int)ceil(p * sorted.size()) - 1;
+	return sorted[max(0, min(rank, (int)sorted.size() - 1))];
+}
+
+/**
+ * FUNCTION NAME: report
+ *
+ * DESCRIPTION: Print the results of the run as a JSON object
+ */
+void Benchmark::report(FILE *out) {
+	int n = par->EN_GPSZ;
+	long undetected = 0;
+	long live = 0, failed = 0;
+
+	for ( int i = 0; i < n; i++ ) {
+		if ( failedAt[i] >= 0 ) {
+			failed++;
+			continue;
+		}
+		live++;
+		for ( int j = 0; j < n; j++ ) {
+			if ( failedAt[j] >= 0 && known[i][j] ) {
+				undetected++;
+			}
+		}
+	}
+
+	sort(latencies.begin(), latencies.end());
+
+	fprintf(out, "{\"nodes\": %d, \"drop_rate\": %g, \"failure\": \"%s\", \"partial_view\": %d, ",
+			n, par->DROP_MSG ? par->MSG_DROP_PROB : 0.0, failureNames[failure], par->PARTIAL_VIEW);
+	fprintf(out, "\"run_time\": %d, \"fail_time\": %d, \"failed\": %ld, ", runningTime, failTime, failed);
+	if ( convergedAt != -1 ) {
+		fprintf(out, "\"join_convergence\": %d, ", convergedAt - joinEnd);
+	}
+	else {
+		fprintf(out, "\"join_convergence\": null, ");
+	}
+	fprintf(out, "\"detection_latency\": {");
+	if ( !latencies.empty() ) {
+		fprintf(out, "\"p50\": %d, \"p90\": %d, \"p99\": %d, \"max\": %d, ",
+				percentile(latencies, .5), percentile(latencies, .9), percentile(latencies, .99), latencies.back());
+	}
+	fprintf(out, "\"samples\": %d, \"undetected\": %ld}, ", (int)latencies.size(), undetected);
+	// The share of the observed pairs that saw a false removal at least once
+	fprintf(out, "\"false_removals\": %ld, \"false_positive_rate\": %g, ",
+			falseRemovals, observedPairs > 0 ? (double)falsePairs / observedPairs : 0.0);
+	fprintf(out, "\"msgs_per_node_tick\": %.3f, \"bytes_per_node_tick\": %.1f, ",
+			nodeTicks ? (double)msgs / nodeTicks : 0.0, nodeTicks ? (double)bytes / nodeTicks : 0.0);
+	fprintf(out, "\"steady_msgs_per_node_tick\": %.3f, \"steady_bytes_per_node_tick\": %.1f}",
+			steadyNodeTicks ? (double)steadyMsgs / steadyNodeTicks : 0.0, steadyNodeTicks ? (double)steadyBytes / steadyNodeTicks : 0.0);
+}
+
+/**
+ * FUNCTION NAME: splitList
+ *
+ * DESCRIPTION: Split a comma separated value into its items
+ */
+static vector<string> splitList(char *value) {
+	vector<string> items;
+	for ( char *item = strtok(value, ","); item; item = strtok(NULL, ",") ) {
+		items.push_back(item);
+	}
+	return items;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Run every combination of the sweep and print a JSON array to stdout
+ **********************************/
+int main(int argc, char *argv[]) {
+	if ( argc != ARGS_COUNT ) {
+		cerr<<"Sweep configuration (i.e., bench.conf) file required"<<endl;
+		return FAILURE;
+	}
+
+	FILE *fp = fopen(argv[1], "r");
+	if ( !fp ) {
+		cerr<<"Cannot open "<<argv[1]<<endl;
+		return FAILURE;
+	}
+
+	vector<string> sizes(1, "10");
+	vector<string> dropRates(1, "0");
+	vector<string> failures(1, "single");
+	int runTime = BENCH_RUNNING_TIME;
+	int failTime = 0;
+	string options;
+	char name[64];
+	char value[256];
+
+	while ( fscanf(fp, " %63[^:]: %255s", name, value) == 2 ) {
+		if ( 0 == strcmp(name, "SIZES") ) {
+			sizes = splitList(value);
+		}
+		else if ( 0 == strcmp(name, "DROP_RATES") ) {
+			dropRates = splitList(value);
+		}
+		else if ( 0 == strcmp(name, "FAILURES") ) {
+			failures = splitList(value);
+		}
+		else if ( 0 == strcmp(name, "RUN_TIME") ) {
+			runTime = min(atoi(value), MAX_TIME);
+		}
+		else if ( 0 == strcmp(name, "FAIL_TIME") ) {
+			failTime = atoi(value);
+		}
+		else {
+			options += string(name) + ": " + value + "\n";
+		}
+	}
+	fclose(fp);
+
+	// The protocol reports progress on stdout; keep it for the JSON
+	cout.rdbuf(NULL);
+
+	printf("[");
+	bool first = true;
+	for ( auto &size : sizes ) {
+		for ( auto &dropRate : dropRates ) {
+			for ( auto &failureName : failures ) {
+				int pattern;
+				for ( pattern = FAIL_NONE; pattern <= FAIL_RANDOM; pattern++ ) {
+					if ( failureName == failureNames[pattern] ) {
+						break;
+					}
+				}
+				if ( pattern > FAIL_RANDOM ) {
+					cerr<<"Unknown failure pattern "<<failureName<<endl;
+					return FAILURE;
+				}
+
+				int n = atoi(size.c_str());
+				double drop = atof(dropRate.c_str());
+				FILE *conf = fopen(BENCH_RUN_CONF, "w");
+				fprintf(conf, "MAX_NNB: %d\nSINGLE_FAILURE: 0\nDROP_MSG: %d\nMSG_DROP_PROB: %g\n", n, drop > 0, drop);
+				// Introduce everyone within 50 ticks and make room for the traffic of large groups
+				fprintf(conf, "STEP_RATE: %g\nMAX_INFLIGHT: %d\n", min(.25, 50.0 / n), max(ENBUFFSIZE, 64 * n));
+				fprintf(conf, "%s", options.c_str());
+				fclose(conf);
+
+				cerr<<"bench: nodes="<<n<<" drop_rate="<<drop<<" failure="<<failureName<<endl;
+				Benchmark *bench = new Benchmark((char *)BENCH_RUN_CONF, (FailurePattern)pattern, runTime, failTime);
+				bench->run();
+				printf("%s\n", first ? "" : ",");
+				bench->report(stdout);
+				fflush(stdout);
+				delete bench;
+				first = false;
+			}
+		}
+	}
+	printf("\n]\n");
+
+	remove(BENCH_RUN_CONF);
+	return SUCCESS;
+}
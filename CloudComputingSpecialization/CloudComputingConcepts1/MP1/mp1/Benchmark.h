@@ -0,0 +1,81 @@
+/**********************************
+ * FILE NAME: Benchmark.h
+ *
+ * DESCRIPTION: Header file of the membership protocol benchmark driver
+ **********************************/
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include "stdincludes.h"
+#include "Application.h"
+#include "Log.h"
+
+/*
+ * Macros
+ */
+#define BENCH_RUN_CONF "bench_run.conf"
+#define BENCH_RUNNING_TIME 300
+// ticks after the last node is introduced before nodes are failed
+#define BENCH_FAIL_DELAY 50
+// fraction of the nodes failed by the random failure pattern
+#define BENCH_RANDOM_FAILURES 0.1
+
+/**
+ * Failure patterns
+ */
+enum FailurePattern {
+	FAIL_NONE,
+	FAIL_SINGLE,
+	FAIL_MULTI,
+	FAIL_RANDOM
+};
+
+/**
+ * CLASS NAME: Benchmark
+ *
+ * DESCRIPTION: Runs the membership protocol like Application does, but
+ * 				instead of grading dbg.log it follows every node add and
+ * 				remove and reports:
+ * 				- failure detection latency over all live observers
+ * 				- false removals of live members
+ * 				- the time until every node knows every other node
+ * 				- messages and bytes sent per node per tick
+ */
+class Benchmark: public Application, public LogObserver {
+private:
+	FailurePattern failure;
+	int failTime;
+	int joinEnd;
+	// known[i][j] is set while node i has node j in its membership list
+	vector<vector<bool> > known;
+	vector<int> knownCount;
+	// time node i was failed, -1 while it is up
+	vector<int> failedAt;
+	vector<int> latencies;
+	// pairs (i, j) in which node i ever listed node j while it was up, and
+	// those in which i removed j while j was up, each counted once
+	vector<vector<bool> > observed;
+	vector<vector<bool> > falselyRemoved;
+	long observedPairs;
+	long falsePairs;
+	long falseRemovals;
+	int convergedAt;
+	long msgs, bytes, nodeTicks;
+	long steadyMsgs, steadyBytes, steadyNodeTicks;
+
+	int index(Address *addr);
+	bool isUp(int i);
+	void failNodes();
+	void sample();
+
+public:
+	Benchmark(char *infile, FailurePattern failure, int runTime, int failTime);
+	void fail();
+	void nodeAdded(Address *thisNode, Address *addedAddr);
+	void nodeRemoved(Address *thisNode, Address *removedAddr);
+	void report(FILE *out);
+	virtual ~Benchmark() {}
+};
+
+#endif /* _BENCHMARK_H_ */
@@ -23,6 +23,10 @@ EmulNet::EmulNet(Params *p)
 			recv_msgs[i][j] = 0;
 		}
 	}
+	for ( j = 0; j < MAX_TIME; j++ ) {
+		total_msgs[j] = 0;
+		total_bytes[j] = 0;
+	}
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
@@ -39,6 +43,10 @@ EmulNet::EmulNet(EmulNet &anotherEmulNet) {
 			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
 		}
 	}
+	for ( j = 0; j < MAX_TIME; j++ ) {
+		this->total_msgs[j] = anotherEmulNet.total_msgs[j];
+		this->total_bytes[j] = anotherEmulNet.total_bytes[j];
+	}
 	this->emulnet = anotherEmulNet.emulnet;
 }
 
@@ -55,6 +63,10 @@ EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
 			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
 		}
 	}
+	for ( j = 0; j < MAX_TIME; j++ ) {
+		this->total_msgs[j] = anotherEmulNet.total_msgs[j];
+		this->total_bytes[j] = anotherEmulNet.total_bytes[j];
+	}
 	this->emulnet = anotherEmulNet.emulnet;
 	return *this;
 }
@@ -88,8 +100,10 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
 	en_msg *em;
 	static char temp[2048];
 	int sendmsg = rand() % 100;
+	int dst = *(int *)(toaddr->addr);
+	int buffsize = par->MAX_INFLIGHT > 0 ? par->MAX_INFLIGHT : ENBUFFSIZE;
 
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+	if( (emulnet.currbuffsize >= buffsize) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) || dst < 0 ) {
 		return 0;
 	}
 
@@ -100,15 +114,22 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
 	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
 	memcpy(em + 1, data, size);
 
-	emulnet.buff[emulnet.currbuffsize++] = em;
+	if ( dst >= (int)emulnet.buff.size() ) {
+		emulnet.buff.resize(dst + 1);
+	}
+	emulnet.buff[dst].push_back(em);
+	emulnet.currbuffsize++;
 
 	int src = *(int *)(myaddr->addr);
 	int time = par->getcurrtime();
 
-	assert(src <= MAX_NODES);
 	assert(time < MAX_TIME);
 
-	sent_msgs[src][time]++;
+	if ( src <= MAX_NODES ) {
+		sent_msgs[src][time]++;
+	}
+	total_msgs[time]++;
+	total_bytes[time] += size;
 
 	#ifdef DEBUGLOG
 		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
@@ -147,28 +168,32 @@ int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct ti
 	char* tmp;
 	int sz;
 	en_msg *emsg;
+	int dst = *(int *)(myaddr->addr);
+	int time = par->getcurrtime();
 
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
+	if ( dst < 0 || dst >= (int)emulnet.buff.size() ) {
+		return 0;
+	}
 
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
+	// Only this node's bucket is visited; newest message first, as before
+	vector<en_msg *> inbox;
+	inbox.swap(emulnet.buff[dst]);
+	emulnet.currbuffsize -= (int)inbox.size();
 
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+	for( i = (int)inbox.size() - 1; i >= 0; i-- ) {
+		emsg = inbox[i];
 
-			(*enq)(queue, (char *)tmp, sz);
+		sz = emsg->size;
+		tmp = (char *) malloc(sz * sizeof(char));
+		memcpy(tmp, (char *)(emsg+1), sz);
 
-			free(emsg);
+		(*enq)(queue, (char *)tmp, sz);
 
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
+		free(emsg);
 
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+		assert(time < MAX_TIME);
 
+		if ( dst <= MAX_NODES ) {
 			recv_msgs[dst][time]++;
 		}
 	}
@@ -188,11 +213,15 @@ int EmulNet::ENcleanup() {
 
 	FILE* file = fopen("msgcount.log", "w+");
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
+	for ( i = 0; i < (int)emulnet.buff.size(); i++ ) {
+		for ( j = 0; j < (int)emulnet.buff[i].size(); j++ ) {
+			free(emulnet.buff[i][j]);
+		}
+		emulnet.buff[i].clear();
 	}
+	emulnet.currbuffsize = 0;
 
-	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
+	for ( i = 1; i <= par->EN_GPSZ && i <= MAX_NODES; i++ ) {
 		fprintf(file, "node %3d ", i);
 		sent_total = 0;
 		recv_total = 0;
@@ -218,3 +247,21 @@ int EmulNet::ENcleanup() {
 	fclose(file);
 	return 0;
 }
+
+/**
+ * FUNCTION NAME: getSentMsgs
+ *
+ * DESCRIPTION: Returns the number of messages sent by all nodes at the given time
+ */
+long EmulNet::getSentMsgs(int time) {
+	return (time >= 0 && time < MAX_TIME) ? total_msgs[time] : 0;
+}
+
+/**
+ * FUNCTION NAME: getSentBytes
+ *
+ * DESCRIPTION: Returns the number of payload bytes sent by all nodes at the given time
+ */
+long EmulNet::getSentBytes(int time) {
+	return (time >= 0 && time < MAX_TIME) ? total_bytes[time] : 0;
+}
@@ -0,0 +1,438 @@
+/**********************************
+ * FILE NAME: HyParView.cpp
+ *
+ * DESCRIPTION: Definition of the HyParView partial view overlay
+ **********************************/
+
+#include "HyParView.h"
+
+/**
+ * Constructor
+ */
+HyParView::HyParView(Address *address, EmulNet *emulNet, Params *params, Log *log): liveness(params->getcurrtime()) {
+	this->emulNet = emulNet;
+	this->log = log;
+	this->par = params;
+	this->self = *address;
+	this->selfId = overlayId(address);
+	this->listener = NULL;
+
+	// Defaults from the paper: log(n) + c active, k times as many passive
+	activeSize = par->ACTIVE_VIEW_SIZE > 0 ? par->ACTIVE_VIEW_SIZE : (unsigned int)log2(max(par->EN_GPSZ, 2)) + 1;
+	passiveSize = par->PASSIVE_VIEW_SIZE > 0 ? par->PASSIVE_VIEW_SIZE : 6 * activeSize;
+}
+
+/**
+ * FUNCTION NAME: setListener
+ *
+ * DESCRIPTION: Register the listener notified of neighborhood changes
+ */
+void HyParView::setListener(OverlayListener *listener) {
+	this->listener = listener;
+}
+
+/**
+ * FUNCTION NAME: send
+ *
+ * DESCRIPTION: Send an overlay message carrying a list of node ids
+ */
+void HyParView::send(int to, ViewMsgTypes msgType, int subject, int ttl, int flag, const vector<int> &ids) {
+	vector<unsigned char> payload;
+	MemberListCodec::encode(ids, payload);
+	sendViewMessage(emulNet, &self, to, msgType, subject, (short)ttl, (short)flag, payload);
+}
+
+/**
+ * FUNCTION NAME: isActive
+ *
+ * DESCRIPTION: Returns true if id is in the active view
+ */
+bool HyParView::isActive(int id) {
+	return find(active.begin(), active.end(), id) != active.end();
+}
+
+/**
+ * FUNCTION NAME: isPassive
+ *
+ * DESCRIPTION: Returns true if id is in the passive view
+ */
+bool HyParView::isPassive(int id) {
+	return find(passive.begin(), passive.end(), id) != passive.end();
+}
+
+/**
+ * FUNCTION NAME: touch
+ *
+ * DESCRIPTION: Record that an active neighbor was heard from now
+ */
+void HyParView::touch(int id) {
+	auto it = livenessTimers.find(id);
+	if ( it != livenessTimers.end() ) {
+		liveness.cancel(it->second);
+	}
+	livenessTimers[id] = liveness.schedule(par->getcurrtime() + VIEW_TIMEOUT, id);
+}
+
+/**
+ * FUNCTION NAME: addToActive
+ *
+ * DESCRIPTION: Make id a neighbor, disconnecting a random neighbor if the active view is full
+ */
+void HyParView::addToActive(int id) {
+	if ( id == selfId || isActive(id) ) {
+		return;
+	}
+
+	if ( active.size() >= activeSize ) {
+		int victim = active[rand() % active.size()];
+		send(victim, DISCONNECT, selfId, 0, 0, vector<int>());
+		dropFromActive(victim, false);
+	}
+
+	passive.erase(remove(passive.begin(), passive.end(), id), passive.end());
+	pendingNeighbors.erase(id);
+	active.push_back(id);
+	touch(id);
+
+#ifdef DEBUGLOG
+	log->LOG(&self, "HyParView: active view gained %d", id);
+#endif
+
+	if ( listener ) {
+		listener->onNeighborUp(id);
+	}
+}
+
+/**
+ * FUNCTION NAME: dropFromActive
+ *
+ * DESCRIPTION: Remove id from the active view. A neighbor that disconnected
+ * 				is kept as a backup in the passive view, a failed one is forgotten.
+ */
+void HyParView::dropFromActive(int id, bool failed) {
+	auto it = find(active.begin(), active.end(), id);
+	if ( it == active.end() ) {
+		return;
+	}
+	active.erase(it);
+
+	auto timer = livenessTimers.find(id);
+	if ( timer != livenessTimers.end() ) {
+		liveness.cancel(timer->second);
+		livenessTimers.erase(timer);
+	}
+
+	if ( !failed ) {
+		addToPassive(id);
+	}
+
+#ifdef DEBUGLOG
+	log->LOG(&self, "HyParView: active view lost %d%s", id, failed ? ", failed" : "");
+#endif
+
+	if ( listener ) {
+		listener->onNeighborDown(id, failed);
+	}
+}
+
+/**
+ * FUNCTION NAME: addToPassive
+ *
+ * DESCRIPTION: Remember id as a backup peer, evicting a random one if the passive view is full
+ */
+void HyParView::addToPassive(int id) {
+	if ( id == selfId || isActive(id) || isPassive(id) ) {
+		return;
+	}
+
+	if ( passive.size() >= passiveSize ) {
+		passive.erase(passive.begin() + rand() % passive.size());
+	}
+	passive.push_back(id);
+}
+
+/**
+ * FUNCTION NAME: randomPeer
+ *
+ * DESCRIPTION: Pick a random active neighbor other than exclude1 and exclude2
+ *
+ * RETURNS:
+ * the neighbor id, or -1 if there is none
+ */
+int HyParView::randomPeer(int exclude1, int exclude2) {
+	vector<int> candidates;
+	for ( int id : active ) {
+		if ( id != exclude1 && id != exclude2 ) {
+			candidates.push_back(id);
+		}
+	}
+	if ( candidates.empty() ) {
+		return -1;
+	}
+	return candidates[rand() % candidates.size()];
+}
+
+/**
+ * FUNCTION NAME: sample
+ *
+ * DESCRIPTION: Append up to count distinct random ids of from to ids
+ */
+void HyParView::sample(const vector<int> &from, unsigned int count, vector<int> &ids) {
+	vector<int> pool(from);
+	for ( unsigned int i = 0; i < count && !pool.empty(); i++ ) {
+		int pick = rand() % pool.size();
+		ids.push_back(pool[pick]);
+		pool[pick] = pool.back();
+		pool.pop_back();
+	}
+}
+
+/**
+ * FUNCTION NAME: join
+ *
+ * DESCRIPTION: Ask contact to introduce this node to the group
+ */
+void HyParView::join(Address *contact) {
+	int contactId = overlayId(contact);
+	if ( contactId == selfId ) {
+		// I am the group booter
+		return;
+	}
+	send(contactId, VIEWJOIN, selfId, 0, 0, vector<int>());
+}
+
+/**
+ * FUNCTION NAME: leave
+ *
+ * DESCRIPTION: Tell every neighbor this node is shutting down and forget both views
+ */
+void HyParView::leave() {
+	for ( int id : active ) {
+		send(id, DISCONNECT, selfId, 0, 1, vector<int>());
+	}
+
+	for ( auto &timer : livenessTimers ) {
+		liveness.cancel(timer.second);
+	}
+	livenessTimers.clear();
+	active.clear();
+	passive.clear();
+	pendingNeighbors.clear();
+}
+
+/**
+ * FUNCTION NAME: recv
+ *
+ * DESCRIPTION: Message handler for the overlay message types
+ */
+bool HyParView::recv(char *data, int size) {
+	ViewMsgHdr *msg = parseViewMessage(data, size);
+	if ( !msg || msg->msgType > VIEWPONG ) {
+		return false;
+	}
+
+	int from = overlayId(&msg->fromAddr);
+	if ( isActive(from) ) {
+		touch(from);
+	}
+
+	switch ( (ViewMsgTypes)msg->msgType ) {
+		case VIEWJOIN: {
+			addToActive(from);
+			send(from, NEIGHBORREPLY, selfId, 0, 1, vector<int>());
+			for ( int id : active ) {
+				if ( id != from ) {
+					send(id, FORWARDJOIN, from, ARWL, 0, vector<int>());
+				}
+			}
+			if ( listener ) {
+				listener->onJoinRequest(from);
+			}
+			break;
+		}
+
+		case FORWARDJOIN: {
+			int subject = msg->subject;
+			if ( subject == selfId ) {
+				break;
+			}
+			if ( msg->ttl == PRWL ) {
+				addToPassive(subject);
+			}
+			int next = randomPeer(from, subject);
+			if ( msg->ttl <= 0 || active.size() <= 1 || next == -1 ) {
+				if ( !isActive(subject) ) {
+					addToActive(subject);
+					send(subject, NEIGHBORREPLY, selfId, 0, 1, vector<int>());
+				}
+			}
+			else {
+				send(next, FORWARDJOIN, subject, msg->ttl - 1, 0, vector<int>());
+			}
+			break;
+		}
+
+		case NEIGHBOR: {
+			// High priority requests come from nodes with an empty active view
+			bool accept = msg->flag || active.size() < activeSize;
+			if ( accept ) {
+				addToActive(from);
+			}
+			else {
+				addToPassive(from);
+			}
+			send(from, NEIGHBORREPLY, selfId, 0, accept ? 1 : 0, vector<int>());
+			break;
+		}
+
+		case NEIGHBORREPLY: {
+			pendingNeighbors.erase(from);
+			if ( msg->flag ) {
+				addToActive(from);
+			}
+			break;
+		}
+
+		case DISCONNECT: {
+			// A peer that is shutting down is forgotten like a failed one, so
+			// the ring hears about it even if its own LEAVE event is lost
+			dropFromActive(from, msg->flag != 0);
+			if ( msg->flag ) {
+				passive.erase(remove(passive.begin(), passive.end(), from), passive.end());
+			}
+			break;
+		}
+
+		case SHUFFLE: {
+			MemberListCodec::Decoder members(msg->ml, msg->size);
+			vector<int> received;
+			int id;
+			while ( members.next(id) ) {
+				received.push_back(id);
+			}
+
+			int next = msg->ttl > 1 ? randomPeer(from, msg->subject) : -1;
+			if ( next != -1 ) {
+				send(next, SHUFFLE, msg->subject, msg->ttl - 1, 0, received);
+				break;
+			}
+
+			if ( msg->subject != selfId ) {
+				vector<int> reply;
+				sample(passive, received.size(), reply);
+				send(msg->subject, SHUFFLEREPLY, selfId, 0, 0, reply);
+			}
+			for ( int member : received ) {
+				addToPassive(member);
+			}
+			break;
+		}
+
+		case SHUFFLEREPLY: {
+			MemberListCodec::Decoder members(msg->ml, msg->size);
+			int id;
+			while ( members.next(id) ) {
+				addToPassive(id);
+			}
+			break;
+		}
+
+		case VIEWPING: {
+			send(from, VIEWPONG, selfId, 0, 0, vector<int>());
+			break;
+		}
+
+		case VIEWPONG:
+		default:
+			break;
+	}
+
+	return true;
+}
+
+/**
+ * FUNCTION NAME: promote
+ *
+ * DESCRIPTION: Ask one passive peer at a time to fill a free slot of the active view
+ */
+void HyParView::promote() {
+	int currenttime = par->getcurrtime();
+
+	// Peers that did not answer in time are presumed dead
+	for ( auto it = pendingNeighbors.begin(); it != pendingNeighbors.end(); ) {
+		if ( it->second <= currenttime ) {
+			passive.erase(remove(passive.begin(), passive.end(), it->first), passive.end());
+			it = pendingNeighbors.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	if ( active.size() >= activeSize || !pendingNeighbors.empty() ) {
+		return;
+	}
+
+	vector<int> candidate;
+	sample(passive, 1, candidate);
+	if ( candidate.empty() ) {
+		return;
+	}
+
+	pendingNeighbors[candidate[0]] = currenttime + VIEW_TIMEOUT;
+	send(candidate[0], NEIGHBOR, selfId, 0, active.empty() ? 1 : 0, vector<int>());
+}
+
+/**
+ * FUNCTION NAME: shuffle
+ *
+ * DESCRIPTION: Exchange a sample of both views with a node found by a random walk
+ */
+void HyParView::shuffle() {
+	int next = randomPeer(-1, -1);
+	if ( next == -1 ) {
+		return;
+	}
+
+	vector<int> ids;
+	ids.push_back(selfId);
+	sample(active, SHUFFLE_KA, ids);
+	sample(passive, SHUFFLE_KP, ids);
+	send(next, SHUFFLE, selfId, ARWL, 0, ids);
+}
+
+/**
+ * FUNCTION NAME: tick
+ *
+ * DESCRIPTION: Drop silent neighbors, probe the rest, refill the active view and shuffle
+ */
+void HyParView::tick() {
+	int currenttime = par->getcurrtime();
+
+	vector<long> silent;
+	liveness.advance(currenttime, silent);
+	for ( long id : silent ) {
+		livenessTimers.erase((int)id);
+		dropFromActive((int)id, true);
+	}
+
+	for ( int id : active ) {
+		send(id, VIEWPING, selfId, 0, 0, vector<int>());
+	}
+
+	promote();
+
+	// Stagger the shuffles of different nodes over the period
+	if ( par->SHUFFLE_PERIOD > 0 && (currenttime + selfId) % par->SHUFFLE_PERIOD == 0 ) {
+		shuffle();
+	}
+}
+
+/**
+ * FUNCTION NAME: neighbors
+ *
+ * DESCRIPTION: Returns the active view
+ */
+void HyParView::neighbors(vector<int> &ids) {
+	ids = active;
+}
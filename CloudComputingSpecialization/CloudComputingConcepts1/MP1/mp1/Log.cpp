@@ -12,6 +12,8 @@
 Log::Log(Params *p) {
 	par = p;
 	firstTime = false;
+	observer = NULL;
+	quiet = false;
 }
 
 /**
@@ -20,6 +22,8 @@ Log::Log(Params *p) {
 Log::Log(const Log &anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->observer = anotherLog.observer;
+	this->quiet = anotherLog.quiet;
 }
 
 /**
@@ -28,6 +32,8 @@ Log::Log(const Log &anotherLog) {
 Log& Log::operator = (const Log& anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->observer = anotherLog.observer;
+	this->quiet = anotherLog.quiet;
 	return *this;
 }
 
@@ -43,6 +49,10 @@ Log::~Log() {}
  */
 void Log::LOG(Address *addr, const char * str, ...) {
 
+	if ( quiet ) {
+		return;
+	}
+
 	static FILE *fp;
 	static FILE *fp2;
 	va_list vararglist;
@@ -114,6 +124,9 @@ void Log::LOG(Address *addr, const char * str, ...) {
  * DESCRIPTION: To Log a node add
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
+	if ( observer ) {
+		observer->nodeAdded(thisNode, addedAddr);
+	}
 	static char stdstring[100];
 	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
     LOG(thisNode, stdstring);
@@ -125,7 +138,28 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
  * DESCRIPTION: To log a node remove
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-	static char stdstring[30];
+	if ( observer ) {
+		observer->nodeRemoved(thisNode, removedAddr);
+	}
+	static char stdstring[100];
 	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
     LOG(thisNode, stdstring);
 }
+
+/**
+ * FUNCTION NAME: setObserver
+ *
+ * DESCRIPTION: Register an observer of node adds and removes
+ */
+void Log::setObserver(LogObserver *observer) {
+	this->observer = observer;
+}
+
+/**
+ * FUNCTION NAME: setQuiet
+ *
+ * DESCRIPTION: Stop writing dbg.log; the observer is still notified
+ */
+void Log::setQuiet(bool quiet) {
+	this->quiet = quiet;
+}
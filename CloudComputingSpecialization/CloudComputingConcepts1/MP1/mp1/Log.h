@@ -20,6 +20,18 @@
 #define DBG_LOG "dbg.log"
 #define STATS_LOG "stats.log"
 
+/**
+ * CLASS NAME: LogObserver
+ *
+ * DESCRIPTION: Notified of every membership change a node logs
+ */
+class LogObserver {
+public:
+	virtual void nodeAdded(Address *thisNode, Address *addedAddr) = 0;
+	virtual void nodeRemoved(Address *thisNode, Address *removedAddr) = 0;
+	virtual ~LogObserver() {}
+};
+
 /**
  * CLASS NAME: Log
  *
@@ -29,6 +41,8 @@ class Log{
 private:
 	Params *par;
 	bool firstTime;
+	LogObserver *observer;
+	bool quiet;
 public:
 	Log(Params *p);
 	Log(const Log &anotherLog);
@@ -37,6 +51,8 @@ public:
 	void LOG(Address *, const char * str, ...);
 	void logNodeAdd(Address *, Address *);
 	void logNodeRemove(Address *, Address *);
+	void setObserver(LogObserver *observer);
+	void setQuiet(bool quiet);
 };
 
 #endif /* _LOG_H_ */
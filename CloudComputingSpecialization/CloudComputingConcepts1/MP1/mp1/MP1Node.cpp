@@ -25,12 +25,19 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
 	this->log = log;
 	this->par = params;
 	this->memberNode->addr = *address;
+	this->overlay = NULL;
+	this->ringChannel = NULL;
+	this->joinAttempt = 0;
+	this->joinDeadline = 0;
 }
 
 /**
  * Destructor of the MP1Node class
  */
-MP1Node::~MP1Node() {}
+MP1Node::~MP1Node() {
+	delete ringChannel;
+	delete overlay;
+}
 
 /**
  * FUNCTION NAME: recvLoop
@@ -109,6 +116,12 @@ int MP1Node::initThisNode(Address *joinaddr) {
 	memberNode->timeOutCounter = -1;
     initMemberListTable(memberNode);
 
+    if ( par->PARTIAL_VIEW ) {
+        overlay = new HyParView(&memberNode->addr, emulNet, par, log);
+        ringChannel = new RingChannel(memberNode, overlay, emulNet, par, log);
+        overlay->setListener(ringChannel);
+    }
+
     return 0;
 }
 
@@ -130,16 +143,23 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 #endif
         memberNode->inGroup = true;
     }
+    else if ( overlay ) {
+#ifdef DEBUGLOG
+        log->LOG(&memberNode->addr, "Trying to join...");
+#endif
+        overlay->join(joinaddr);
+        joinDeadline = par->getcurrtime() + par->JOIN_TIMEOUT;
+    }
     else {
-        size_t msgsize = sizeof(MessageHdr);
-        msg = (MessageHdr *) malloc(msgsize * sizeof(char));
+        size_t msgsize = MSGHDR_SIZE;
+        msg = (MessageHdr *) malloc(sizeof(MessageHdr));
 
         // create JOINREQ message: format of data is {struct Address myaddr}
         msg->msgType = JOINREQ;
+        msg->version = ML_WIRE_VERSION;
         memcpy( (void *) &msg->fromAddr, &memberNode->addr, sizeof(memberNode->addr));
-        memcpy( (void *) &msg->heartbeat, &memberNode->heartbeat, sizeof(long));
+        msg->heartbeat = par->getcurrtime();
         msg->size = 0;
-        msg->ml[0] = 0;
 
 #ifdef DEBUGLOG
         sprintf(s, "Trying to join...");
@@ -148,6 +168,7 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 
         // send JOINREQ message to introducer member
         emulNet->ENsend(&memberNode->addr, joinaddr, (char *)msg, msgsize);
+        joinDeadline = par->getcurrtime() + par->JOIN_TIMEOUT;
 
         free(msg);
     }
@@ -165,6 +186,35 @@ int MP1Node::finishUpThisNode(){
    /*
     * Your code goes here
     */
+
+    if (!memberNode->inited || !memberNode->inGroup || memberNode->bFailed)
+    {
+        return 0;
+    }
+
+    //
+    // Tell the group right away instead of letting it time this node out
+    //
+    if (overlay)
+    {
+        ringChannel->leave();
+        overlay->leave();
+    }
+    else
+    {
+        vector<Address> members;
+        for (const auto &entry : ml)
+        {
+            Address ToAddr;
+            ToAddr.init();
+            *(int *)(&ToAddr.addr) = entry.first;
+            members.push_back(ToAddr);
+        }
+        SendMessage(members, LEAVE);
+    }
+
+    memberNode->inGroup = false;
+    return 0;
 }
 
 /**
@@ -180,9 +230,11 @@ void MP1Node::nodeLoop() {
 
     // Check my messages
     checkMessages();
+    answerJoins();
 
     // Wait until you're in the group...
     if( !memberNode->inGroup ) {
+        retryJoin();
     	return;
     }
 
@@ -211,11 +263,69 @@ void MP1Node::checkMessages() {
     return;
 }
 
+/**
+ * FUNCTION NAME: retryJoin
+ *
+ * DESCRIPTION: Move on to the next introducer if the current one did not answer in time
+ */
+void MP1Node::retryJoin()
+{
+    if (par->getcurrtime() < joinDeadline)
+    {
+        return;
+    }
+
+    joinAttempt++;
+    Address joinaddr = getJoinAddress();
+    introduceSelfToGroup(&joinaddr);
+}
+
+/**
+ * FUNCTION NAME: answerJoins
+ *
+ * DESCRIPTION: Answer the JOINREQs received this tick with one shared membership
+ * 				snapshot, at most JOIN_BATCH of them; the rest wait for the next tick
+ */
+void MP1Node::answerJoins()
+{
+    if (pendingJoins.empty())
+    {
+        return;
+    }
+
+    size_t count = pendingJoins.size();
+    if (par->JOIN_BATCH > 0)
+    {
+        count = min(count, (size_t)par->JOIN_BATCH);
+    }
+
+    vector<Address> joiners;
+    for (size_t i = 0; i < count; i++)
+    {
+        Address ToAddr;
+        ToAddr.init();
+        *(int *)(&ToAddr.addr) = pendingJoins[i];
+        joiners.push_back(ToAddr);
+    }
+    pendingJoins.erase(pendingJoins.begin(), pendingJoins.begin() + count);
+
+    SendMessage(joiners, JOINREP);
+}
+
 bool MP1Node::SendMessage(Address *ToAddr,
                           MsgTypes MsgType)
 {
-    auto OutputMsgSize = sizeof(MessageHdr) + sizeof(int) * ml.size();
-    MessageHdr *OutputMsg = (MessageHdr *)malloc(OutputMsgSize);
+    return SendMessage(vector<Address>(1, *ToAddr), MsgType);
+}
+
+bool MP1Node::SendMessage(const vector<Address> &ToAddrs,
+                          MsgTypes MsgType)
+{
+    vector<unsigned char> payload;
+    MemberListCodec::encode(ml, payload);
+
+    auto OutputMsgSize = MSGHDR_SIZE + payload.size();
+    MessageHdr *OutputMsg = (MessageHdr *)malloc(max(OutputMsgSize, sizeof(MessageHdr)));
 
     if (!OutputMsg)
     {
@@ -223,22 +333,92 @@ bool MP1Node::SendMessage(Address *ToAddr,
     }
 
     OutputMsg->msgType = MsgType;
+    OutputMsg->version = ML_WIRE_VERSION;
     OutputMsg->fromAddr = memberNode->addr;
     OutputMsg->heartbeat = par->getcurrtime();
-    auto index = 0;
-    for (const auto &entry : ml)
+    OutputMsg->size = (int)payload.size();
+    if (!payload.empty())
     {
-        OutputMsg->ml[index++] = entry.first;
+        memcpy(OutputMsg->ml, payload.data(), payload.size());
     }
-    OutputMsg->size = index;
 
-    emulNet->ENsend(&memberNode->addr, ToAddr, (char *)OutputMsg, OutputMsgSize);
+    for (auto ToAddr : ToAddrs)
+    {
+        emulNet->ENsend(&memberNode->addr, &ToAddr, (char *)OutputMsg, OutputMsgSize);
+    }
 
     free(OutputMsg);
 
     return true;
 }
 
+/**
+ * FUNCTION NAME: touchMember
+ *
+ * DESCRIPTION: Record that a member was heard from now and push its expiry deadline out
+ */
+void MP1Node::touchMember(int id)
+{
+    auto currenttime = par->getcurrtime();
+    ml[id] = currenttime;
+
+    auto it = expiryTimers.find(id);
+    if (it != expiryTimers.end())
+    {
+        expiry.cancel(it->second);
+    }
+    expiryTimers[id] = expiry.schedule(currenttime + TPONG + 1, id);
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: Drop a member that timed out or left
+ */
+void MP1Node::removeMember(int id)
+{
+    auto it = ml.find(id);
+    if (it == ml.end())
+    {
+        return;
+    }
+    ml.erase(it);
+
+    auto timer = expiryTimers.find(id);
+    if (timer != expiryTimers.end())
+    {
+        expiry.cancel(timer->second);
+        expiryTimers.erase(timer);
+    }
+
+    Address addr;
+    memset(&addr, 0, sizeof(Address));
+    *(int *)(&addr.addr) = id;
+    *(short *)(&addr.addr[4]) = 0;
+
+    log->logNodeRemove(&memberNode->addr, &addr);
+}
+
+/**
+ * FUNCTION NAME: hasDeparted
+ *
+ * DESCRIPTION: Returns true if id left the group recently
+ */
+bool MP1Node::hasDeparted(int id)
+{
+    auto it = departed.find(id);
+    if (it == departed.end())
+    {
+        return false;
+    }
+    if (par->getcurrtime() - it->second > TREMOVE)
+    {
+        departed.erase(it);
+        return false;
+    }
+    return true;
+}
+
 /**
  * FUNCTION NAME: recvCallBack
  *
@@ -249,49 +429,90 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
 	 * Your code goes here
 	 */
 
-    if (size < (sizeof(MessageHdr)))
+    if (overlay)
+    {
+        // Only members of the group can introduce others; the joiner retries elsewhere
+        if (!memberNode->inGroup && size > 0 && (unsigned char)data[0] == VIEWJOIN)
+        {
+            return false;
+        }
+        return overlay->recv(data, size) || ringChannel->recv(data, size);
+    }
+
+    if (size < (int)MSGHDR_SIZE)
     {
         return false;
     }
 
     MessageHdr *InputMsg = (MessageHdr *)data;
 
-    switch (InputMsg->msgType)
+    if (InputMsg->version != ML_WIRE_VERSION ||
+        InputMsg->size < 0 ||
+        InputMsg->size > size - (int)MSGHDR_SIZE)
+    {
+        return false;
+    }
+
+    MemberListCodec::Decoder members(InputMsg->ml, InputMsg->size);
+
+    auto gone = departed.find(*(int *)(&InputMsg->fromAddr.addr));
+    if (gone != departed.end())
+    {
+        // Sent before its LEAVE: stale
+        if (InputMsg->heartbeat <= gone->second)
+        {
+            return false;
+        }
+        // Sent after it: the node is back
+        departed.erase(gone);
+    }
+
+    switch ((MsgTypes)InputMsg->msgType)
     {
 
     case JOINREQ:
     {
-        int id = InputMsg->fromAddr.addr[0];
+        // Only members of the group can introduce others; the joiner retries elsewhere
+        if (!memberNode->inGroup)
+        {
+            return false;
+        }
+
+        int id = *(int *)(&InputMsg->fromAddr.addr);
 
         auto it = ml.find(id);
 
         if (it == ml.end())
         {
-            ml[id] = par->getcurrtime();
+            touchMember(id);
             log->logNodeAdd(&memberNode->addr, &InputMsg->fromAddr);
         }
 
-        return SendMessage(&InputMsg->fromAddr, JOINREP);
+        // Answered together with the other joins of this tick, see answerJoins
+        if (find(pendingJoins.begin(), pendingJoins.end(), id) == pendingJoins.end())
+        {
+            pendingJoins.push_back(id);
+        }
+        return true;
     }
 
     case JOINREP:
     {
-        int id = InputMsg->fromAddr.addr[0];
+        int id = *(int *)(&InputMsg->fromAddr.addr);
 
         auto it = ml.find(id);
 
         if (it == ml.end())
         {
-            ml[id] = par->getcurrtime();
+            touchMember(id);
             log->logNodeAdd(&memberNode->addr, &InputMsg->fromAddr);
             memberNode->inGroup = true;
         }
 
-        int selfid = memberNode->addr.addr[0];
-        for (int i = 0; i < InputMsg->size; ++i)
+        int selfid = *(int *)(&memberNode->addr.addr);
+        while (members.next(id))
         {
-            id = InputMsg->ml[i];
-            if (id == selfid)
+            if (id == selfid || hasDeparted(id))
             {
                 continue;
             }
@@ -299,10 +520,10 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
             auto it = ml.find(id);
             if (it == ml.end())
             {
-                ml[id] = par->getcurrtime();
+                touchMember(id);
                 Address member;
                 memset(&member, 0, sizeof(Address));
-                member.addr[0] = id;
+                *(int *)(&member.addr) = id;
                 log->logNodeAdd(&memberNode->addr, &member);
             }
         }
@@ -317,26 +538,23 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
 
     case PONG:
     {
-        int id = InputMsg->fromAddr.addr[0];
+        int id = *(int *)(&InputMsg->fromAddr.addr);
         auto it = ml.find(id);
 
         if (it != ml.end())
         {
-            ml[id] = par->getcurrtime();
+            touchMember(id);
         }
         else
         {
-            ml[id] = par->getcurrtime();
+            touchMember(id);
             log->logNodeAdd(&memberNode->addr, &InputMsg->fromAddr);
         }
 
-        int selfid = memberNode->addr.addr[0];
-        for (int i = 0; i < InputMsg->size; ++i)
+        int selfid = *(int *)(&memberNode->addr.addr);
+        while (members.next(id))
         {
-
-            id = InputMsg->ml[i];
-
-            if (id == selfid)
+            if (id == selfid || hasDeparted(id))
             {
                 continue;
             }
@@ -346,7 +564,7 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
             {
                 Address member;
                 memset(&member, 0, sizeof(Address));
-                member.addr[0] = id;
+                *(int *)(&member.addr) = id;
 
                 SendMessage(&member, PING);
             }
@@ -354,6 +572,15 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
         break;
     }
 
+    case LEAVE:
+    {
+        int id = *(int *)(&InputMsg->fromAddr.addr);
+
+        departed[id] = InputMsg->heartbeat;
+        removeMember(id);
+        break;
+    }
+
     default:
     {
         return false;
@@ -377,31 +604,26 @@ void MP1Node::nodeLoopOps() {
 	 * Your code goes here
 	 */
 
+    if (overlay)
+    {
+        overlay->tick();
+        ringChannel->tick();
+        return;
+    }
+
     //
-    // Collect nodes which have not ponged for a while
+    // Collect nodes which have not ponged for a while:
+    // only their expiry timers fire, the rest of ml is not visited
     //
-    auto currenttime = par->getcurrtime();
-    vector<int> noheartbeats;
-    for (const auto entry:ml) {
-
-      if (currenttime - entry.second > 2) {
-          noheartbeats.push_back(entry.first);
-      }
-    }
+    vector<long> noheartbeats;
+    expiry.advance(par->getcurrtime(), noheartbeats);
 
     //
     // Delete those nodes
     //
     for (auto entry: noheartbeats) {
-    
-      ml.erase(ml.find(entry));
-      
-      Address addr;
-      memset(&addr, 0, sizeof(Address));
-      *(int *)(&addr.addr) = entry;
-      *(short *)(&addr.addr[4]) = 0;
-      
-      log->logNodeRemove(&memberNode->addr, &addr);
+      expiryTimers.erase(entry);
+      removeMember(entry);
     }
 
     //  
@@ -432,13 +654,26 @@ int MP1Node::isNullAddress(Address *addr) {
 /**
  * FUNCTION NAME: getJoinAddress
  *
- * DESCRIPTION: Returns the Address of the coordinator
+ * DESCRIPTION: Returns the Address of the introducer to join through.
+ * 				The first seed boots the group. Other nodes spread over the
+ * 				seeds by id and move on to the next seed on every retry.
  */
 Address MP1Node::getJoinAddress() {
     Address joinaddr;
+    int selfid = *(int *)(&memberNode->addr.addr);
+    const vector<int> &seeds = par->SEEDS;
+    int introducer = seeds[0];
+
+    for (size_t i = 0; selfid != seeds[0] && i < seeds.size(); i++) {
+        int candidate = seeds[(selfid + joinAttempt + i) % seeds.size()];
+        if (candidate != selfid) {
+            introducer = candidate;
+            break;
+        }
+    }
 
     memset(&joinaddr, 0, sizeof(Address));
-    *(int *)(&joinaddr.addr) = 1;
+    *(int *)(&joinaddr.addr) = introducer;
     *(short *)(&joinaddr.addr[4]) = 0;
 
     return joinaddr;
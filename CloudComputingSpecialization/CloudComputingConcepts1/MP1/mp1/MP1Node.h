@@ -14,12 +14,19 @@
 #include "Member.h"
 #include "EmulNet.h"
 #include "Queue.h"
+#include "MemberListCodec.h"
+#include "TimingWheel.h"
+#include "Overlay.h"
+#include "HyParView.h"
+#include "RingChannel.h"
 
 /**
  * Macros
  */
 #define TREMOVE 20
 #define TFAIL 5
+// ticks without a PONG after which a member is removed
+#define TPONG 2
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
@@ -33,22 +40,29 @@ enum MsgTypes{
     JOINREP,
 	PING,
 	PONG,
+	LEAVE,
     DUMMYLASTMSGTYPE
 };
 
 /**
  * STRUCT NAME: Message
  *
- * DESCRIPTION: Header and content of a message
+ * DESCRIPTION: Header and content of a message.
+ * 				The fields are laid out without padding; ml carries size bytes of
+ * 				membership list encoded by MemberListCodec in wire format version.
  */
 typedef struct MessageHdr {
-	enum MsgTypes msgType;
+	unsigned char msgType;
+	unsigned char version;
 	Address fromAddr;
 	int heartbeat;
 	int size;
-	int ml[1];
+	unsigned char ml[1];
 } MessageHdr;
 
+// Size of the fixed part of a message, i.e. without the membership payload
+#define MSGHDR_SIZE offsetof(MessageHdr, ml)
+
 /**
  * CLASS NAME: MP1Node
  *
@@ -63,9 +77,31 @@ private:
 	char NULLADDR[6];
 	// membership list : key-node id, value-node hb;
 	map<int,int> ml;
+	// expiry deadline of every member in ml
+	TimingWheel expiry;
+	unordered_map<int, TimingWheel::TimerId> expiryTimers;
+	// partial view mode (Params::PARTIAL_VIEW): the overlay replaces ml and the
+	// ring channel maintains memberNode->memberList
+	Overlay *overlay;
+	RingChannel *ringChannel;
+	// introducers tried so far and when to give up on the current one
+	int joinAttempt;
+	int joinDeadline;
+	// joiners to answer with the next membership snapshot
+	vector<int> pendingJoins;
+	// members that announced they left : key-node id, value-time of the LEAVE.
+	// Older messages from them and, for TREMOVE ticks, other members' lists
+	// mentioning them are ignored.
+	map<int,int> departed;
 
 private:
     bool SendMessage(Address *, MsgTypes);
+    bool SendMessage(const vector<Address> &, MsgTypes);
+    void answerJoins();
+    void retryJoin();
+    void touchMember(int id);
+    void removeMember(int id);
+    bool hasDeparted(int id);
 
 public:
 	MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
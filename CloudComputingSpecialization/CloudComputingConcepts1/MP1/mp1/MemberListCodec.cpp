@@ -0,0 +1,134 @@
+/**********************************
+ * FILE NAME: MemberListCodec.cpp
+ *
+ * DESCRIPTION: Definition of the membership list wire codec
+ **********************************/
+
+#include "MemberListCodec.h"
+
+/**
+ * FUNCTION NAME: putVarint
+ *
+ * DESCRIPTION: Append an unsigned LEB128 varint to the buffer
+ */
+void MemberListCodec::putVarint(vector<unsigned char> &buf, unsigned int value) {
+	while ( value >= 0x80 ) {
+		buf.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	buf.push_back((unsigned char)value);
+}
+
+/**
+ * FUNCTION NAME: getVarint
+ *
+ * DESCRIPTION: Read one unsigned LEB128 varint and move pos past it
+ *
+ * RETURNS:
+ * true on success
+ * false on a truncated or oversized varint
+ */
+bool MemberListCodec::getVarint(const unsigned char *&pos, const unsigned char *end, unsigned int &value) {
+	value = 0;
+	for ( int shift = 0; shift < 32 && pos < end; shift += 7 ) {
+		unsigned char byte = *pos++;
+		value |= (unsigned int)(byte & 0x7f) << shift;
+		if ( !(byte & 0x80) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: encodeSorted
+ *
+ * DESCRIPTION: Encode ids produced by [it, end) in ascending order as delta + varint runs
+ */
+template <typename Iter, typename GetId>
+static void encodeSorted(Iter it, Iter end, GetId getId, vector<unsigned char> &buf) {
+	unsigned int last = 0;
+
+	while ( it != end ) {
+		unsigned int first = (unsigned int)getId(*it);
+		unsigned int runEnd = first;
+		++it;
+		while ( it != end && (unsigned int)getId(*it) == runEnd + 1 ) {
+			++runEnd;
+			++it;
+		}
+
+		unsigned int gap = first - last;
+		bool hasRun = runEnd != first;
+		MemberListCodec::putVarint(buf, (gap << 1) | (hasRun ? 1 : 0));
+		if ( hasRun ) {
+			MemberListCodec::putVarint(buf, runEnd - first - 1);
+		}
+		last = runEnd;
+	}
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Encode the ids (keys) of a membership table. std::map keeps them sorted.
+ */
+void MemberListCodec::encode(const map<int, int> &ml, vector<unsigned char> &buf) {
+	encodeSorted(ml.begin(), ml.end(), [](const pair<const int, int> &entry) { return entry.first; }, buf);
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Encode a list of ids. The list is sorted and deduplicated first.
+ */
+void MemberListCodec::encode(const vector<int> &ids, vector<unsigned char> &buf) {
+	vector<int> sorted(ids);
+	sort(sorted.begin(), sorted.end());
+	sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+	encodeSorted(sorted.begin(), sorted.end(), [](int id) { return id; }, buf);
+}
+
+/**
+ * Constructor
+ */
+MemberListCodec::Decoder::Decoder(const unsigned char *data, int size): pos(data), end(data + (size > 0 ? size : 0)), last(0), runLeft(0) {}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Decode the next id
+ *
+ * RETURNS:
+ * true if an id was decoded
+ * false at the end of the buffer or on malformed input
+ */
+bool MemberListCodec::Decoder::next(int &id) {
+	if ( runLeft > 0 ) {
+		--runLeft;
+		id = (int)++last;
+		return true;
+	}
+
+	if ( pos >= end ) {
+		return false;
+	}
+
+	unsigned int header;
+	if ( !getVarint(pos, end, header) ) {
+		pos = end;
+		return false;
+	}
+	if ( header & 1 ) {
+		unsigned int extra;
+		if ( !getVarint(pos, end, extra) ) {
+			pos = end;
+			return false;
+		}
+		runLeft = extra + 1;
+	}
+
+	last += header >> 1;
+	id = (int)last;
+	return true;
+}
@@ -0,0 +1,79 @@
+/**********************************
+ * FILE NAME: Overlay.cpp
+ *
+ * DESCRIPTION: Helpers shared by the overlay implementations
+ **********************************/
+
+#include "Overlay.h"
+
+/**
+ * FUNCTION NAME: overlayAddress
+ *
+ * DESCRIPTION: Returns the Address of the node with the given id
+ */
+Address overlayAddress(int id) {
+	Address addr;
+	addr.init();
+	*(int *)(&addr.addr) = id;
+	*(short *)(&addr.addr[4]) = 0;
+	return addr;
+}
+
+/**
+ * FUNCTION NAME: overlayId
+ *
+ * DESCRIPTION: Returns the id of the node at the given Address
+ */
+int overlayId(Address *addr) {
+	return *(int *)(&addr->addr);
+}
+
+/**
+ * FUNCTION NAME: parseViewMessage
+ *
+ * DESCRIPTION: Validate a received buffer as an overlay message
+ *
+ * RETURNS:
+ * the message header, or NULL if the buffer is not a well formed overlay message
+ */
+ViewMsgHdr *parseViewMessage(char *data, int size) {
+	if ( size < (int)VIEWMSGHDR_SIZE ) {
+		return NULL;
+	}
+
+	ViewMsgHdr *msg = (ViewMsgHdr *)data;
+	if ( msg->msgType < OVERLAY_MSGTYPE_BASE ||
+		 msg->version != VIEW_WIRE_VERSION ||
+		 msg->size < 0 ||
+		 msg->size > size - (int)VIEWMSGHDR_SIZE ) {
+		return NULL;
+	}
+
+	return msg;
+}
+
+/**
+ * FUNCTION NAME: sendViewMessage
+ *
+ * DESCRIPTION: Build an overlay message and send it to the node with id to
+ */
+void sendViewMessage(EmulNet *emulNet, Address *from, int to, unsigned char msgType, int subject, short ttl, short flag, const vector<unsigned char> &payload) {
+	size_t msgsize = VIEWMSGHDR_SIZE + payload.size();
+	ViewMsgHdr *msg = (ViewMsgHdr *)malloc(max(msgsize, sizeof(ViewMsgHdr)));
+
+	msg->msgType = msgType;
+	msg->version = VIEW_WIRE_VERSION;
+	msg->fromAddr = *from;
+	msg->subject = subject;
+	msg->ttl = ttl;
+	msg->flag = flag;
+	msg->size = (int)payload.size();
+	if ( !payload.empty() ) {
+		memcpy(msg->ml, payload.data(), payload.size());
+	}
+
+	Address toAddr = overlayAddress(to);
+	emulNet->ENsend(from, &toAddr, (char *)msg, (int)msgsize);
+
+	free(msg);
+}
@@ -24,11 +24,32 @@ void Params::setparams(char *config_file) {
 	fscanf(fp,"\nDROP_MSG: %d", &DROP_MSG);
 	fscanf(fp,"\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
 
+	/*
+	 * Optional settings
+	 */
+	PARTIAL_VIEW = 0;
+	ACTIVE_VIEW_SIZE = 0;
+	PASSIVE_VIEW_SIZE = 0;
+	SHUFFLE_PERIOD = 10;
+	RING_SYNC_PERIOD = 5;
+	SEEDS.assign(1, 1);
+	JOIN_TIMEOUT = 5;
+	JOIN_BATCH = 0;
+	GRACEFUL_LEAVE = 0;
+	MAX_INFLIGHT = 0;
+
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
 	STEP_RATE=.25;
 	MAX_MSG_SIZE = 4000;
+
+	// Optional settings may override the defaults above
+	char name[64];
+	char value[64];
+	while ( fscanf(fp, " %63[^:]: %63s", name, value) == 2 ) {
+		setoption(name, value);
+	}
 	globaltime = 0;
 	dropmsg = 0;
 	allNodesJoined = 0;
@@ -39,6 +60,56 @@ void Params::setparams(char *config_file) {
 	return;
 }
 
+/**
+ * FUNCTION NAME: setoption
+ *
+ * DESCRIPTION: Set one optional parameter. Unknown names are ignored.
+ */
+void Params::setoption(char *name, char *value) {
+	if ( 0 == strcmp(name, "PARTIAL_VIEW") ) {
+		PARTIAL_VIEW = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "ACTIVE_VIEW_SIZE") ) {
+		ACTIVE_VIEW_SIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "PASSIVE_VIEW_SIZE") ) {
+		PASSIVE_VIEW_SIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "SHUFFLE_PERIOD") ) {
+		SHUFFLE_PERIOD = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "RING_SYNC_PERIOD") ) {
+		RING_SYNC_PERIOD = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "SEEDS") ) {
+		// comma separated list of node ids
+		SEEDS.clear();
+		for ( char *id = strtok(value, ","); id; id = strtok(NULL, ",") ) {
+			if ( atoi(id) > 0 ) {
+				SEEDS.push_back(atoi(id));
+			}
+		}
+		if ( SEEDS.empty() ) {
+			SEEDS.assign(1, 1);
+		}
+	}
+	else if ( 0 == strcmp(name, "JOIN_TIMEOUT") ) {
+		JOIN_TIMEOUT = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "JOIN_BATCH") ) {
+		JOIN_BATCH = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "GRACEFUL_LEAVE") ) {
+		GRACEFUL_LEAVE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "MAX_INFLIGHT") ) {
+		MAX_INFLIGHT = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "STEP_RATE") ) {
+		STEP_RATE = atof(value);
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
@@ -31,8 +31,20 @@ public:
 	int globaltime;
 	int allNodesJoined;
 	short PORTNUM;
+	// Optional settings, given as extra "NAME: value" lines in the test case file
+	int PARTIAL_VIEW;           // use HyParView partial views instead of full membership
+	int ACTIVE_VIEW_SIZE;       // HyParView active view size, 0 to derive from EN_GPSZ
+	int PASSIVE_VIEW_SIZE;      // HyParView passive view size, 0 to derive from EN_GPSZ
+	int SHUFFLE_PERIOD;         // ticks between HyParView shuffles
+	int RING_SYNC_PERIOD;       // ticks between ring anti-entropy pushes
+	vector<int> SEEDS;          // introducer node ids, the first one boots the group
+	int JOIN_TIMEOUT;           // ticks to wait for an introducer before trying the next one
+	int JOIN_BATCH;             // max joins an introducer answers per tick, 0 for no limit
+	int MAX_INFLIGHT;           // messages the emulated network holds at once, 0 for ENBUFFSIZE
+	int GRACEFUL_LEAVE;         // stopped nodes leave the group (and hand off their keys) instead of crashing
 	Params();
 	void setparams(char *);
+	void setoption(char *name, char *value);
 	int getcurrtime();
 };
 
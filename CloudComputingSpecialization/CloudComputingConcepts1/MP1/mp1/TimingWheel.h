@@ -0,0 +1,65 @@
+/**********************************
+ * FILE NAME: TimingWheel.h
+ *
+ * DESCRIPTION: Header file of the hierarchical timing wheel
+ **********************************/
+
+#ifndef _TIMINGWHEEL_H_
+#define _TIMINGWHEEL_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Number of wheels and log2 of the slots per wheel. Together they cover
+// 2^(WHEEL_LEVELS * WHEEL_BITS) ticks; later deadlines are parked in the
+// outermost wheel and re-cascaded until they come into range.
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+
+/**
+ * CLASS NAME: TimingWheel
+ *
+ * DESCRIPTION: Hierarchical timing wheel keyed by global time (Params::getcurrtime).
+ * 				Scheduling and cancelling a timer are O(1); advancing the wheel costs
+ * 				one slot visit per tick plus the timers that fire or cascade.
+ * 				Each timer carries a caller-defined key (member id, transaction id...)
+ * 				which is handed back when the timer fires.
+ */
+class TimingWheel {
+public:
+	// 0 is never a valid timer id
+	typedef unsigned long TimerId;
+
+	TimingWheel(int now = 0);
+	TimerId schedule(int deadline, long key);
+	bool cancel(TimerId id);
+	void advance(int now, vector<long> &expired);
+	unsigned long size();
+	int now();
+
+private:
+	typedef struct Timer {
+		int deadline;
+		long key;
+		int prev;
+		int next;
+		int slot;
+		unsigned int generation;
+	} Timer;
+
+	vector<Timer> timers;
+	vector<int> freeTimers;
+	int heads[WHEEL_LEVELS * WHEEL_SLOTS];
+	int current;
+	unsigned long active;
+
+	int slotFor(int deadline);
+	void link(int index);
+	void unlink(int index);
+	void cascade(int level);
+};
+
+#endif /* _TIMINGWHEEL_H_ */
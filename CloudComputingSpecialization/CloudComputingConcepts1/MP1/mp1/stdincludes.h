@@ -18,6 +18,7 @@
  * Standard Header files
  */
 #include <stdio.h>
+#include <stddef.h>
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
@@ -31,6 +32,7 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <algorithm>
 #include <queue>
@@ -80,6 +80,9 @@ Application::~Application() {
 	delete log;
 	delete en;
 	delete en1;
+	for ( size_t i = 0; i < clients.size(); i++ ) {
+		delete clients[i];
+	}
 	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
 		delete mp1[i];
 		delete mp2[i];
@@ -121,13 +124,13 @@ int Application::run()
 	}
 
 	// Clean up
-	en->ENcleanup();
-	en1->ENcleanup();
-
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
 		 mp1[i]->finishUpThisNode();
 	}
 
+	en->ENcleanup();
+	en1->ENcleanup();
+
 	return SUCCESS;
 }
 
@@ -223,6 +226,12 @@ void Application::mp2Run() {
 	 */
 	if ( par->getcurrtime() == INSERT_TIME ) {
 		insertTestKVPairs();
+		if ( par->COUNTER_CLIENTS > 0 ) {
+			startCounterClients();
+		}
+	}
+	if ( !clients.empty() ) {
+		checkCounterClients();
 	}
 
 	/**
@@ -364,6 +373,21 @@ void Application::fail() {
 
 }
 
+/**
+ * FUNCTION NAME: stopNode
+ *
+ * DESCRIPTION: Take node i down. It crashes, unless GRACEFUL_LEAVE is set: then it
+ * 				hands its keys off and leaves the group first.
+ */
+void Application::stopNode(int i) {
+	if ( par->GRACEFUL_LEAVE ) {
+		mp2[i]->handoffKeys();
+		mp1[i]->finishUpThisNode();
+	}
+	mp2[i]->getMemberNode()->bFailed = true;
+	mp1[i]->getMemberNode()->bFailed = true;
+}
+
 /**
  * FUNCTION NAME: getjoinaddr
  *
@@ -373,7 +397,7 @@ Address Application::getjoinaddr(void){
 	//trace.funcEntry("Application::getjoinaddr");
     Address joinaddr;
     joinaddr.init();
-    *(int *)(&(joinaddr.addr))=1;
+    *(int *)(&(joinaddr.addr))=par->SEEDS[0];
     *(short *)(&(joinaddr.addr[4]))=0;
     //trace.funcExit("Application::getjoinaddr", SUCCESS);
     return joinaddr;
@@ -427,18 +451,128 @@ void Application::insertTestKVPairs() {
 	 */
 	initTestKVPairs();
 
-	for ( map<string, string>::iterator it = testKVPairs.begin(); it != testKVPairs.end(); ++it ) {
-		// Step 1. Find a node that is alive
+	if ( par->BULK_LOAD ) {
+		// The pairs come out of the map sorted by key
+		vector<pair<string, string> > pairs(testKVPairs.begin(), testKVPairs.end());
+
 		number = findARandomNodeThatIsAlive();
+		log->LOG(&mp2[number]->getMemberNode()->addr, "BULK LOAD OPERATION KEYS: %d at time: %d", (int)pairs.size(), par->getcurrtime());
+		mp2[number]->bulkLoad(pairs);
+		cout<<endl<<"Sent " <<testKVPairs.size() <<" pairs to the ring in one bulk load"<<endl;
+		return;
+	}
+
+	map<string, string> batch;
+	for ( map<string, string>::iterator it = testKVPairs.begin(); it != testKVPairs.end(); ++it ) {
+		// Step 1. Find a node that is alive, once per batch
+		if ( batch.empty() ) {
+			number = findARandomNodeThatIsAlive();
+		}
 
 		// Step 2. Issue a create operation
 		log->LOG(&mp2[number]->getMemberNode()->addr, "CREATE OPERATION KEY: %s VALUE: %s at time: %d", it->first.c_str(), it->second.c_str(), par->getcurrtime());
-		mp2[number]->clientCreate(it->first, it->second);
+		if ( par->BATCH_SIZE <= 0 ) {
+			mp2[number]->clientCreate(it->first, it->second);
+			continue;
+		}
+		batch[it->first] = it->second;
+		if ( (int)batch.size() == par->BATCH_SIZE || next(it) == testKVPairs.end() ) {
+			mp2[number]->multiPut(batch);
+			batch.clear();
+		}
 	}
 
 	cout<<endl<<"Sent " <<testKVPairs.size() <<" create messages to the ring"<<endl;
 }
 
+/**
+ * Constructor
+ */
+CounterClient::CounterClient(MP2Node *node, const string &key): KVTask(node), key(key), round(0), correct(false) {}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Create the counter, then read it and write it back one higher
+ * 				COUNTER_ROUNDS times. The client gives up at the first
+ * 				operation that fails.
+ */
+void CounterClient::run() {
+	KV_TASK_BEGIN
+	KV_AWAIT(create(key, "0"));
+	if ( !result->success ) {
+		KV_TASK_EXIT;
+	}
+	for ( round = 0; round < COUNTER_ROUNDS; round++ ) {
+		KV_AWAIT(get(key));
+		if ( !result->success ) {
+			KV_TASK_EXIT;
+		}
+		KV_AWAIT(update(key, to_string(atoi(result->value.c_str()) + 1)));
+		if ( !result->success ) {
+			KV_TASK_EXIT;
+		}
+	}
+	KV_AWAIT(get(key));
+	correct = result->success && result->value == to_string(COUNTER_ROUNDS);
+	KV_TASK_END
+}
+
+/**
+ * FUNCTION NAME: startCounterClients
+ *
+ * DESCRIPTION: Start COUNTER_CLIENTS read-modify-write clients, spread over the
+ * 				nodes, each on a counter of its own
+ */
+void Application::startCounterClients() {
+	clientsStart = par->getcurrtime();
+	clientsReported = false;
+	for ( int i = 0; i < par->COUNTER_CLIENTS; i++ ) {
+		clients.push_back(new CounterClient(mp2[i % par->EN_GPSZ], "counter" + to_string(i)));
+		clients.back()->start();
+	}
+	cout<<endl<<"Started " <<clients.size() <<" read-modify-write clients"<<endl;
+}
+
+/**
+ * FUNCTION NAME: checkCounterClients
+ *
+ * DESCRIPTION: Once every client is finished, or the tests start, log how many
+ * 				finished with their counter right to the stats log. Finished
+ * 				clients are dropped from then on; one still waiting on an
+ * 				operation is resumed by its handle, so it is kept until it
+ * 				finishes or the Application is deleted.
+ */
+void Application::checkCounterClients() {
+	int finished = 0;
+	int correct = 0;
+
+	for ( size_t i = 0; i < clients.size(); i++ ) {
+		finished += clients[i]->finished();
+		correct += clients[i]->correct;
+	}
+	if ( !clientsReported ) {
+		if ( finished < (int)clients.size() && par->getcurrtime() < TEST_TIME ) {
+			return;
+		}
+		log->LOG(&mp2[0]->getMemberNode()->addr, "#STATSLOG# %d read-modify-write clients of %d rounds: %d finished, %d correct, in %d ticks",
+				 (int)clients.size(), COUNTER_ROUNDS, finished, correct, par->getcurrtime() - clientsStart);
+		cout<<endl<<correct <<" of " <<clients.size() <<" read-modify-write clients counted right"<<endl;
+		clientsReported = true;
+	}
+
+	size_t waiting = 0;
+	for ( size_t i = 0; i < clients.size(); i++ ) {
+		if ( clients[i]->finished() ) {
+			delete clients[i];
+		}
+		else {
+			clients[waiting++] = clients[i];
+		}
+	}
+	clients.resize(waiting);
+}
+
 /**
  * FUNCTION NAME: deleteTest
  *
@@ -451,15 +585,26 @@ void Application::deleteTest() {
 	 */
 	cout<<endl<<"Deleting "<<testKVPairs.size()/2 <<" valid keys.... ... .. . ."<<endl;
 	map<string, string>::iterator it = testKVPairs.begin();
+	vector<string> batch;
 	for ( int i = 0; i < testKVPairs.size()/2; i++ ) {
 		it++;
 
-		// Step 1.a. Find a node that is alive
-		number = findARandomNodeThatIsAlive();
+		// Step 1.a. Find a node that is alive, once per batch
+		if ( batch.empty() ) {
+			number = findARandomNodeThatIsAlive();
+		}
 
 		// Step 1.b. Issue a delete operation
 		log->LOG(&mp2[number]->getMemberNode()->addr, "DELETE OPERATION KEY: %s VALUE: %s at time: %d", it->first.c_str(), it->second.c_str(), par->getcurrtime());
-		mp2[number]->clientDelete(it->first);
+		if ( par->BATCH_SIZE <= 0 ) {
+			mp2[number]->clientDelete(it->first);
+			continue;
+		}
+		batch.push_back(it->first);
+		if ( (int)batch.size() == par->BATCH_SIZE || i + 1 == (int)testKVPairs.size()/2 ) {
+			mp2[number]->multiDelete(batch);
+			batch.clear();
+		}
 	}
 
 	/**
@@ -544,8 +689,7 @@ void Application::readTest() {
 		}
 		if ( failedOneNode ) {
 			log->LOG(&mp2[nodeToFail]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-			mp2[nodeToFail]->getMemberNode()->bFailed = true;
-			mp1[nodeToFail]->getMemberNode()->bFailed = true;
+			stopNode(nodeToFail);
 			cout<<endl<<"Failed a replica node"<<endl;
 		}
 		else {
@@ -618,8 +762,7 @@ void Application::readTest() {
 				for ( int i = 0; i < nodesToFail.size(); i++ ) {
 					// Fail a node
 					log->LOG(&mp2[nodesToFail.at(i)]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
-					mp1[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
+					stopNode(nodesToFail.at(i));
 					cout<<endl<<"Failed a replica node"<<endl;
 				}
 			}
@@ -673,8 +816,7 @@ void Application::readTest() {
 					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress() ) {
 					// Step 4.c Fail a non-replica node
 					log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[i]->getMemberNode()->bFailed = true;
-					mp1[i]->getMemberNode()->bFailed = true;
+					stopNode(i);
 					failedOneNode = true;
 					cout<<endl<<"Failed a non-replica node"<<endl;
 					break;
@@ -789,8 +931,7 @@ void Application::updateTest() {
 		}
 		if ( failedOneNode ) {
 			log->LOG(&mp2[nodeToFail]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-			mp2[nodeToFail]->getMemberNode()->bFailed = true;
-			mp1[nodeToFail]->getMemberNode()->bFailed = true;
+			stopNode(nodeToFail);
 			cout<<endl<<"Failed a replica node"<<endl;
 		}
 		else {
@@ -861,8 +1002,7 @@ void Application::updateTest() {
 				for ( int i = 0; i < nodesToFail.size(); i++ ) {
 					// Fail a node
 					log->LOG(&mp2[nodesToFail.at(i)]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
-					mp1[nodesToFail.at(i)]->getMemberNode()->bFailed = true;
+					stopNode(nodesToFail.at(i));
 					cout<<endl<<"Failed a replica node"<<endl;
 				}
 			}
@@ -915,8 +1055,7 @@ void Application::updateTest() {
 					 mp2[i]->getMemberNode()->addr.getAddress() != replicas.at(TERTIARY).getAddress()->getAddress() ) {
 					// Step 4.c Fail a non-replica node
 					log->LOG(&mp2[i]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-					mp2[i]->getMemberNode()->bFailed = true;
-					mp1[i]->getMemberNode()->bFailed = true;
+					stopNode(i);
 					failedOneNode = true;
 					cout<<endl<<"Failed a non-replica node"<<endl;
 					break;
@@ -15,6 +15,7 @@
 #include "EmulNet.h"
 #include "Queue.h"
 #include "MP2Node.h"
+#include "KVTask.h"
 #include "Node.h"
 #include "common.h"
 
@@ -40,6 +41,29 @@ static const char alphanum[] =
 #define RF 3
 #define NUMBER_OF_INSERTS 100
 #define KEY_LENGTH 5
+#define COUNTER_ROUNDS 5
+
+/**
+ * CLASS NAME: CounterClient
+ *
+ * DESCRIPTION: A logical client that creates a counter of its own, adds one to
+ * 				it COUNTER_ROUNDS times by reading and updating it, and reads
+ * 				it back (COUNTER_CLIENTS)
+ */
+class CounterClient: public KVTask {
+private:
+	string key;
+	int round;
+
+protected:
+	void run();
+
+public:
+	// the final read found every round added
+	bool correct;
+
+	CounterClient(MP2Node *node, const string &key);
+};
 
 /**
  * CLASS NAME: Application
@@ -58,6 +82,11 @@ private:
 	MP2Node **mp2;
 	Params *par;
 	map<string, string> testKVPairs;
+	// read-modify-write clients, the time they started and whether they were
+	// reported to the stats log (COUNTER_CLIENTS)
+	vector<CounterClient *> clients;
+	int clientsStart;
+	bool clientsReported;
 public:
 	Application(char *);
 	virtual ~Application();
@@ -67,7 +96,10 @@ public:
 	void mp1Run();
 	void mp2Run();
 	void fail();
+	void stopNode(int i);
 	void insertTestKVPairs();
+	void startCounterClients();
+	void checkCounterClients();
 	int findARandomNodeThatIsAlive();
 	void deleteTest();
 	void readTest();
@@ -37,17 +37,14 @@ public:
 	int nextid;
 	int currbuffsize;
 	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
+	// messages in flight, bucketed by destination node id
+	vector<vector<en_msg *> > buff;
 	EM() {}
 	EM& operator = (EM &anotherEM) {
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->buff = anotherEM.buff;
 		return *this;
 	}
 	int getNextId() {
@@ -82,6 +79,9 @@ private:
 	Params* par;
 	int sent_msgs[MAX_NODES + 1][MAX_TIME];
 	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	// totals over all nodes per time unit, including nodes beyond MAX_NODES
+	long total_msgs[MAX_TIME];
+	long total_bytes[MAX_TIME];
 	int enInited;
 	EM emulnet;
 public:
@@ -94,6 +94,8 @@ public:
 	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
 	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
 	int ENcleanup();
+	long getSentMsgs(int time);
+	long getSentBytes(int time);
 };
 
 #endif /* _EMULNET_H_ */
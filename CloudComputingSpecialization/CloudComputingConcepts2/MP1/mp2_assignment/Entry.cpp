@@ -13,6 +13,20 @@ Entry::Entry(string _value, int _timestamp, ReplicaType _replica){
 	value = _value;
 	timestamp = _timestamp;
 	replica = _replica;
+	expiry = 0;
+}
+
+/**
+ * constructor
+ *
+ * DESCRIPTION: An entry with a time to live, that expires at the given time
+ */
+Entry::Entry(string _value, int _timestamp, ReplicaType _replica, int _expiry){
+	this->delimiter = ":";
+	value = _value;
+	timestamp = _timestamp;
+	replica = _replica;
+	expiry = _expiry;
 }
 
 /**
@@ -36,6 +50,16 @@ Entry::Entry(string entry){
 	value = tuple.at(0);
 	timestamp = stoi(tuple.at(1));
 	replica = static_cast<ReplicaType>(stoi(tuple.at(2)));
+	expiry = tuple.size() > 3 ? stoi(tuple.at(3)) : 0;
+}
+
+/**
+ * FUNCTION NAME: expiredAt
+ *
+ * DESCRIPTION: Returns true if the time to live of the entry ran out by the given time
+ */
+bool Entry::expiredAt(int time) {
+	return expiry != 0 && expiry <= time;
 }
 
 /**
@@ -44,5 +68,10 @@ Entry::Entry(string entry){
  * DESCRIPTION: Convert the object to a string representation
  */
 string Entry::convertToString() {
-	return value + delimiter + to_string(timestamp) + delimiter + to_string(replica);
+	string entry = value + delimiter + to_string(timestamp) + delimiter + to_string(replica);
+
+	// Entries that never expire keep their old form
+	if (expiry != 0)
+		entry += delimiter + to_string(expiry);
+	return entry;
 }
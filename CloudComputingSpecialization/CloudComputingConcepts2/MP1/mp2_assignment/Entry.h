@@ -17,9 +17,13 @@ public:
 	string value;
 	int timestamp;
 	ReplicaType replica;
+	// time the entry expires at, 0 if it never does
+	int expiry;
 	string delimiter;
 
 	Entry(string entry);
 	Entry(string _value, int _timestamp, ReplicaType _replica);
+	Entry(string _value, int _timestamp, ReplicaType _replica, int _expiry);
+	bool expiredAt(int time);
 	string convertToString();
 };
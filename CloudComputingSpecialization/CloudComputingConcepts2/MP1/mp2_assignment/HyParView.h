@@ -0,0 +1,81 @@
+/**********************************
+ * FILE NAME: HyParView.h
+ *
+ * DESCRIPTION: Header file of the HyParView partial view overlay
+ **********************************/
+
+#ifndef _HYPARVIEW_H_
+#define _HYPARVIEW_H_
+
+#include "stdincludes.h"
+#include "Log.h"
+#include "Params.h"
+#include "Member.h"
+#include "EmulNet.h"
+#include "Overlay.h"
+#include "MemberListCodec.h"
+#include "TimingWheel.h"
+
+/*
+ * Macros
+ */
+// Active and passive random walk lengths of a FORWARDJOIN
+#define ARWL 6
+#define PRWL 3
+// Number of active and passive members sent in a SHUFFLE
+#define SHUFFLE_KA 3
+#define SHUFFLE_KP 4
+// ticks without any message from an active neighbor after which it is dropped
+#define VIEW_TIMEOUT 4
+
+/**
+ * CLASS NAME: HyParView
+ *
+ * DESCRIPTION: Hybrid partial view membership (Leitao et al., DSN 2007).
+ * 				Each node keeps a small, symmetric active view that is probed
+ * 				every tick and a larger passive view of backup peers kept
+ * 				fresh by periodic shuffles. Failed active neighbors are
+ * 				replaced from the passive view.
+ */
+class HyParView: public Overlay {
+private:
+	EmulNet *emulNet;
+	Log *log;
+	Params *par;
+	Address self;
+	int selfId;
+	OverlayListener *listener;
+	unsigned int activeSize;
+	unsigned int passiveSize;
+	vector<int> active;
+	vector<int> passive;
+	// deadline by which every active neighbor must have been heard from
+	TimingWheel liveness;
+	unordered_map<int, TimingWheel::TimerId> livenessTimers;
+	// passive peers asked to become neighbors : key-node id, value-reply deadline
+	map<int, int> pendingNeighbors;
+
+	void send(int to, ViewMsgTypes msgType, int subject, int ttl, int flag, const vector<int> &ids);
+	bool isActive(int id);
+	bool isPassive(int id);
+	void addToActive(int id);
+	void dropFromActive(int id, bool failed);
+	void addToPassive(int id);
+	void touch(int id);
+	int randomPeer(int exclude1, int exclude2);
+	void sample(const vector<int> &from, unsigned int count, vector<int> &ids);
+	void promote();
+	void shuffle();
+
+public:
+	HyParView(Address *address, EmulNet *emulNet, Params *params, Log *log);
+	void setListener(OverlayListener *listener);
+	void join(Address *contact);
+	void leave();
+	bool recv(char *data, int size);
+	void tick();
+	void neighbors(vector<int> &ids);
+	virtual ~HyParView() {}
+};
+
+#endif /* _HYPARVIEW_H_ */
@@ -0,0 +1,95 @@
+/**********************************
+ * FILE NAME: KVTask.cpp
+ *
+ * DESCRIPTION: Definition of the client task that waits on key-value operations
+ **********************************/
+
+#include "KVTask.h"
+
+/**
+ * Constructor
+ */
+KVTask::KVTask(MP2Node *node): node(node), resumeAt(0) {}
+
+/**
+ * FUNCTION NAME: start
+ *
+ * DESCRIPTION: Run the task up to the first operation it waits on
+ */
+void KVTask::start() {
+	resumeAt = 0;
+	run();
+}
+
+/**
+ * FUNCTION NAME: finished
+ *
+ * RETURNS:
+ * true once the task ran to its end
+ */
+bool KVTask::finished() {
+	return resumeAt == -1;
+}
+
+/**
+ * FUNCTION NAME: suspend
+ *
+ * DESCRIPTION: Wait on an operation. One decided already, a failed start for
+ * 				instance, does not suspend the task. A callback the handle has
+ * 				already is still called, before the task is queued.
+ *
+ * RETURNS:
+ * true if run must return and be resumed once the operation is decided
+ */
+bool KVTask::suspend(OpHandle op) {
+	result = op;
+	if ( result->done ) {
+		return false;
+	}
+
+	function<void(const OpResult &)> previous = result->callback;
+
+	result->callback = [this, previous](const OpResult &op) {
+		if ( previous ) {
+			previous(op);
+		}
+		node->defer(bind(&KVTask::resume, this));
+	};
+	return true;
+}
+
+/**
+ * FUNCTION NAME: resume
+ *
+ * DESCRIPTION: Go on from the operation the task waited on
+ */
+void KVTask::resume() {
+	if ( !finished() ) {
+		run();
+	}
+}
+
+/**
+ * FUNCTION NAME: get, create, update, remove, scan
+ *
+ * DESCRIPTION: Start an operation at the default consistency levels
+ */
+OpHandle KVTask::get(const string &key) {
+	return node->clientRead(key);
+}
+
+OpHandle KVTask::create(const string &key, const string &value) {
+	return node->clientCreate(key, value);
+}
+
+OpHandle KVTask::update(const string &key, const string &value) {
+	return node->clientUpdate(key, value);
+}
+
+OpHandle KVTask::remove(const string &key) {
+	return node->clientDelete(key);
+}
+
+OpHandle KVTask::scan(const string &start, const string &end, int limit) {
+	return node->clientScan(start, end, limit);
+}
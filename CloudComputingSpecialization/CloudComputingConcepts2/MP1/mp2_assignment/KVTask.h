@@ -0,0 +1,72 @@
+/**********************************
+ * FILE NAME: KVTask.h
+ *
+ * DESCRIPTION: Header file of the client task that waits on key-value operations
+ **********************************/
+
+#ifndef KVTASK_H_
+#define KVTASK_H_
+
+#include "stdincludes.h"
+#include "MP2Node.h"
+
+/*
+ * Macros
+ */
+// The body of KVTask::run goes between KV_TASK_BEGIN and KV_TASK_END. KV_AWAIT
+// starts an operation and leaves run until the operation is decided, then run
+// is entered again at the line after it, the outcome in result. Locals do not
+// live across a KV_AWAIT, what one step hands the next belongs in members of
+// the task, and a line holds at most one KV_AWAIT. KV_TASK_EXIT ends the task
+// before KV_TASK_END.
+#define KV_TASK_BEGIN switch ( resumeAt ) { case 0:
+#define KV_AWAIT(op) \
+	do { \
+		resumeAt = __LINE__; \
+		if ( suspend(op) ) { \
+			return; \
+		} \
+		case __LINE__: ; \
+	} while ( 0 )
+#define KV_TASK_EXIT do { resumeAt = -1; return; } while ( 0 )
+#define KV_TASK_END resumeAt = -1; }
+
+/**
+ * CLASS NAME: KVTask
+ *
+ * DESCRIPTION: A logical client of the store written as straight line code, a
+ * 				read-modify-write for instance, in place of a state machine
+ * 				stepped on the current time. It is resumed from the tick of
+ * 				its node: the callback of the operation it waits on queues it
+ * 				with MP2Node::defer, and checkMessages runs the queue at its
+ * 				end. A task costs its members and one handle while it waits,
+ * 				and must not be deleted before it is finished.
+ */
+class KVTask {
+private:
+	void resume();
+
+protected:
+	MP2Node *node;
+	// line run goes on from, 0 before it starts and -1 once it ended
+	int resumeAt;
+	// the operation waited on last
+	OpHandle result;
+
+	bool suspend(OpHandle op);
+	virtual void run() = 0;
+
+	OpHandle get(const string &key);
+	OpHandle create(const string &key, const string &value);
+	OpHandle update(const string &key, const string &value);
+	OpHandle remove(const string &key);
+	OpHandle scan(const string &start, const string &end, int limit);
+
+public:
+	KVTask(MP2Node *node);
+	void start();
+	bool finished();
+	virtual ~KVTask() {}
+};
+
+#endif /* KVTASK_H_ */
@@ -4,6 +4,7 @@
  * DESCRIPTION: MP2Node class definition
  **********************************/
 #include "MP2Node.h"
+#include <chrono>
 
 /**
  * constructor
@@ -16,6 +17,20 @@ MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Ad
 	this->log = log;
 	ht = new HashTable();
 	this->memberNode->addr = *address;
+	setRingHashSeed(par->HASH_SEED);
+	setRingOrdered(par->ORDERED_PARTITIONER);
+
+	maxReplicas = min(par->REPLICATION_FACTOR, MAX_REPLICAS);
+	minReplicas = maxReplicas;
+	for (auto &keyspace : par->KEYSPACES)
+	{
+		maxReplicas = max(maxReplicas, min(keyspace.second, MAX_REPLICAS));
+		minReplicas = min(minReplicas, min(keyspace.second, MAX_REPLICAS));
+	}
+	nextSample = 0;
+	expiring = false;
+	// Ids are made up of the node id and the time the node started
+	acks.setOwner(*(int *)(&this->memberNode->addr.addr), par->getcurrtime());
 }
 
 /**
@@ -58,9 +73,41 @@ void MP2Node::updateRing()
 	/*
 	 * Step 3: Run the stabilization protocol IF REQUIRED
 	 */
-	// Run stabilization protocol if the hash table size is greater than zero and if there has been a changed in the ring
-	ring = curMemList;
-	stabilizationProtocol();
+	// Run stabilization protocol only if there has been a change in the ring
+	change = !sameRing(ring, curMemList);
+
+	if (change)
+	{
+		ReplicaTable oldTable(replicaTable);
+		ring = curMemList;
+		replicaTable.build(ring, maxReplicas);
+		stabilizationProtocol(oldTable);
+		rebuildTrees();
+	}
+}
+
+/**
+ * FUNCTION NAME: sameRing
+ *
+ * DESCRIPTION: Returns true if both rings hold the same nodes in the same order
+ */
+bool MP2Node::sameRing(vector<Node> &a, vector<Node> &b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].getHashCode() != b[i].getHashCode() ||
+			!(*a[i].getAddress() == *b[i].getAddress()))
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
 /**
@@ -84,25 +131,106 @@ vector<Node> MP2Node::getMembershipList()
 		short port = this->memberNode->memberList.at(i).getport();
 		memcpy(&addressOfThisMember.addr[0], &id, sizeof(int));
 		memcpy(&addressOfThisMember.addr[4], &port, sizeof(short));
-		curMemList.emplace_back(Node(addressOfThisMember));
+		addTokens(curMemList, addressOfThisMember, par);
 	}
 	return curMemList;
 }
 
+/**
+ * FUNCTION NAME: addTokens
+ *
+ * DESCRIPTION: Add the virtual nodes of the node at address to ring. A node gets
+ * 				VNODES tokens, scaled by its weight if WEIGHTS lists it, and at least one.
+ * 				With ORDERED_PARTITIONER the tokens are not hashed but split the
+ * 				ring into ranges (orderedToken), numbered by node id in steps
+ * 				of the most tokens any node has.
+ */
+void MP2Node::addTokens(vector<Node> &ring, Address &address, Params *par)
+{
+	int tokens = par->VNODES;
+	int stride = par->VNODES;
+	auto weight = par->WEIGHTS.find(*(int *)(&address.addr));
+
+	if (weight != par->WEIGHTS.end())
+	{
+		tokens = max(1, (int)lround(par->VNODES * weight->second));
+	}
+
+	if (par->ORDERED_PARTITIONER)
+	{
+		for (auto &other : par->WEIGHTS)
+		{
+			stride = max(stride, (int)lround(par->VNODES * other.second));
+		}
+	}
+
+	for (int token = 0; token < tokens; token++)
+	{
+		ring.emplace_back(Node(address, token));
+		if (par->ORDERED_PARTITIONER)
+		{
+			uint64_t index = (uint64_t)*(int *)(&address.addr) * stride + token;
+
+			ring.back().setHashCode(orderedToken(index));
+		}
+	}
+}
+
 /**
  * FUNCTION NAME: hashFunction
  *
  * DESCRIPTION: This functions hashes the key and returns the position on the ring
  * 				HASH FUNCTION USED FOR CONSISTENT HASHING
+ * 				With ORDERED_PARTITIONER the position keeps key order instead.
  *
  * RETURNS:
- * size_t position on the ring
+ * 64-bit position on the ring
+ */
+uint64_t MP2Node::hashFunction(const string &key)
+{
+	return ringOrdered() ? orderedPosition(key) : ringHash(key);
+}
+
+/**
+ * FUNCTION NAME: replicationFactor
+ *
+ * DESCRIPTION: Returns the number of replicas of key: the one of its keyspace, the
+ * 				text before the first ':', if KEYSPACES lists it, else REPLICATION_FACTOR
+ */
+int MP2Node::replicationFactor(const string &key)
+{
+	size_t colon = key.find(':');
+
+	if (colon != string::npos && !par->KEYSPACES.empty())
+	{
+		auto keyspace = par->KEYSPACES.find(key.substr(0, colon));
+
+		if (keyspace != par->KEYSPACES.end())
+		{
+			return min(keyspace->second, MAX_REPLICAS);
+		}
+	}
+
+	return min(par->REPLICATION_FACTOR, MAX_REPLICAS);
+}
+
+/**
+ * FUNCTION NAME: requiredReplies
+ *
+ * DESCRIPTION: Returns the successful replies out of replicas that satisfy level
  */
-size_t MP2Node::hashFunction(string key)
+int MP2Node::requiredReplies(ConsistencyLevel level, int replicas)
 {
-	std::hash<string> hashFunc;
-	size_t ret = hashFunc(key);
-	return ret % RING_SIZE;
+	switch (level)
+	{
+	case ONE:
+		return 1;
+	case ALL:
+		return replicas;
+	case QUORUM:
+	default:
+		return replicas / 2 + 1;
+	}
 }
 
 ReplicaType MP2Node::GetReplicaType(int replicaIndex)
@@ -119,778 +247,3688 @@ ReplicaType MP2Node::GetReplicaType(int replicaIndex)
 	}
 }
 
-void MP2Node::logSuccess(MessageType msgType,
-						 bool coordinator,
-						 int transID,
-						 string key,
-						 string value)
+/**
+ * FUNCTION NAME: closeTransaction
+ *
+ * DESCRIPTION: Forget a decided transaction and disarm its timeout, once every
+ * 				node asked has answered or nothing waits for the rest
+ */
+void MP2Node::closeTransaction(transInfo *trans)
 {
-	if (transID == 0) return;
-
-	switch (msgType)
-	{
+	bool allAnswered = trans->answered == trans->sent;
 
-	case CREATE:
+	if (trans->held > 0 ||
+		(!allAnswered && (par->HINTED_HANDOFF || (par->READ_REPAIR && trans->type == READ))))
 	{
-		log->logCreateSuccess(&memberNode->addr,
-							  coordinator,
-							  transID,
-							  key,
-							  value);
-
-		break;
+		// Requests waiting in replica windows still go out, replicas that
+		// never answer are suspected, and late read replies compared, until
+		// the timeout fires
+		trans->decided = true;
+		return;
 	}
 
-	case READ:
-	{
-		log->logReadSuccess(&memberNode->addr,
-							coordinator,
-							transID,
-							key,
-							value);
-		
-		break;
-	}
+	readRepair(trans);
+	timeouts.cancel(trans->timer);
+	acks.close(trans);
+}
 
-	case UPDATE:
+/**
+ * FUNCTION NAME: startTransaction
+ *
+ * DESCRIPTION: Register a new coordinator transaction on key and find the replicas
+ * 				it is sent to. replicas is left empty while the ring has fewer
+ * 				nodes than the replication factor of key; such a transaction
+ * 				fails on timeout.
+ *
+ * RETURNS:
+ * the transaction id, 0 if the pending table is full; such a transaction
+ * fails at once
+ */
+TransID MP2Node::startTransaction(MessageType type, string key, string value, ConsistencyLevel level, ReplicaSet &replicas)
+{
+	transInfo *trans = acks.open();
+
+	if (!trans)
 	{
-		log->logUpdateSuccess(&memberNode->addr,
-							  coordinator,
-							  transID,
-							  key,
-							  value);
-		
-		break;
+		// Every slot waits on a transaction already
+		replicas.count = 0;
+		logFail(type, true, 0, key, value);
+		return 0;
 	}
 
-	case DELETE:
+	trans->type = type;
+	trans->key = key;
+	trans->value = value;
+	trans->timestamp = par->getcurrtime();
+	trans->numSucc = 0;
+	trans->numFail = 0;
+	trans->keyHash = hashFunction(key);
+
+	firstReplicas(replicaTable.lookup(trans->keyHash), replicationFactor(key), replicas);
+	trans->replicas = replicas.count;
+	trans->needed = requiredReplies(level, replicas.count);
+	trans->asked = replicas;
+	trans->sent = (1u << replicas.count) - 1;
+	trans->answered = 0;
+	trans->hedgeTimer = 0;
+	for (int index = 0; index < replicas.count; ++index)
 	{
-		log->logDeleteSuccess(&memberNode->addr,
-							  coordinator,
-							  transID,
-							  key);
-
-		break;
-	}
+		trans->sentAt[index] = trans->timestamp;
 	}
+	trans->decided = false;
+	trans->succeeded = false;
+	trans->newestVersion = -1;
+	trans->fullIndex = -1;
+	trans->digested = 0;
+	trans->counted = 0;
+	trans->fetching = 0;
+	trans->haveFull = false;
+	trans->valueAsked = 0;
+	trans->expiry = 0;
+	trans->handle = newHandle(trans->id, type, key);
+	trans->timer = timeouts.schedule(trans->timestamp + TRANS_TIMEOUT, trans->id);
+
+	return trans->id;
 }
 
-void MP2Node::logFail(MessageType msgType,
-					  bool coordinator,
-					  int transID,
-					  string key,
-					  string value)
+/**
+ * FUNCTION NAME: newHandle
+ *
+ * DESCRIPTION: Returns the handle of a client operation requested now
+ */
+OpHandle MP2Node::newHandle(TransID transID, MessageType type, const string &key)
 {
-	if (transID == 0) return;
+	OpHandle handle = make_shared<OpResult>();
+
+	handle->transID = transID;
+	handle->type = type;
+	handle->key = key;
+	handle->done = false;
+	handle->success = false;
+	handle->version = -1;
+	handle->start = par->getcurrtime();
+	handle->latency = 0;
+	return handle;
+}
 
-	switch (msgType)
-	{
+/**
+ * FUNCTION NAME: handleOf
+ *
+ * DESCRIPTION: Returns the handle of a transaction just started, a failed one
+ * 				if it failed at once
+ */
+OpHandle MP2Node::handleOf(TransID transID, MessageType type, const string &key)
+{
+	transInfo *trans = acks.find(transID);
 
-	case CREATE:
+	if (trans)
 	{
-		log->logCreateFail(&memberNode->addr,
-						   coordinator,
-						   transID,
-						   key,
-						   value);
-
-		break;
+		return trans->handle;
 	}
 
-	case READ:
-	{
-		log->logReadFail(&memberNode->addr,
-						 coordinator,
-						 transID,
-						 key);
-
-		break;
-	}
+	OpHandle handle = newHandle(transID, type, key);
+	completeOp(handle, false, "", -1);
+	return handle;
+}
 
-	case UPDATE:
+/**
+ * FUNCTION NAME: completeOp
+ *
+ * DESCRIPTION: Fill in the outcome of a client operation and run its callback
+ */
+void MP2Node::completeOp(OpHandle &handle, bool success, const string &value, int version)
+{
+	if (!handle || handle->done)
 	{
-		log->logUpdateFail(&memberNode->addr,
-						   coordinator,
-						   transID,
-						   key,
-						   value);
-
-		break;
+		return;
 	}
 
-	case DELETE:
+	handle->done = true;
+	handle->success = success;
+	handle->value = value;
+	handle->version = version;
+	handle->latency = par->getcurrtime() - handle->start;
+	if (handle->callback)
 	{
-		log->logDeleteFail(&memberNode->addr,
-						   coordinator,
-						   transID,
-						   key);
-
-		break;
-	}
+		handle->callback(*handle);
 	}
 }
 
 /**
- * FUNCTION NAME: clientCreate
+ * FUNCTION NAME: defer
  *
- * DESCRIPTION: client side CREATE API
- * 				The function does the following:
- * 				1) Constructs the message
- * 				2) Finds the replicas of this key
- * 				3) Sends a message to the replica
+ * DESCRIPTION: Run a continuation at the end of the current tick of this node,
+ * 				after its messages and timeouts are handled, rather than from
+ * 				within the handling of the reply that decided an operation
  */
-void MP2Node::clientCreate(string key, string value)
+void MP2Node::defer(function<void()> resume)
 {
-	/*
-	 * Implement this
-	 */
-
-    auto transID = (!stabilizing) ? ++g_transID : 0;
-
-	transInfo tInfo;
-
-	tInfo.type = CREATE;
-	tInfo.key = key;
-	tInfo.value = value;
-	tInfo.timestamp = par->getcurrtime();
-	tInfo.numSucc = 0;
-	tInfo.numFail = 0;
-
-    acks[transID] = tInfo; 
-
-    auto replicas = findNodes(key);
+	resumptions.push_back(resume);
+}
 
-    for (int index = 0; index < replicas.size(); ++index) 
+/**
+ * FUNCTION NAME: decideTransaction
+ *
+ * DESCRIPTION: Log and close the transaction once enough replicas succeeded for its
+ * 				consistency level, or so many failed that it can no longer succeed
+ */
+void MP2Node::decideTransaction(transInfo *trans, string value)
+{
+	if (trans->numSucc >= trans->needed)
 	{
-		auto replica = replicas[index];
+		trans->succeeded = true;
 
-		Message m(transID, 
-		          memberNode->addr, 
-				  CREATE, 
-				  key, 
-				  value, 
-				  GetReplicaType(index));
-
-        string data(m.toString());
+		logSuccess(trans->type,
+				   true,
+				   trans->id,
+				   trans->key,
+				   value);
+		completeOp(trans->handle, true, value, trans->newestVersion);
 
-	    int size = emulNet->ENsend(&memberNode->addr, 
-		                           replica.getAddress(),
-								   (char *)data.c_str(),
-								   (int)data.length());
+		closeTransaction(trans);
+	}
+	else if (trans->numFail >= trans->replicas - trans->needed + 1)
+	{
+		logFail(trans->type,
+				true,
+				trans->id,
+				trans->key,
+				value);
+		completeOp(trans->handle, false, "", -1);
+
+		closeTransaction(trans);
 	}
 }
 
 /**
- * FUNCTION NAME: clientRead
+ * FUNCTION NAME: recordAnswer
  *
- * DESCRIPTION: client side READ API
- * 				The function does the following:
- * 				1) Constructs the message
- * 				2) Finds the replicas of this key
- * 				3) Sends a message to the replica
+ * DESCRIPTION: Note that from answered the transaction. A suspected node that
+ * 				answers is trusted again.
+ *
+ * RETURNS:
+ * the position of from among the nodes asked, -1 if it was not asked
  */
-void MP2Node::clientRead(string key)
+int MP2Node::recordAnswer(transInfo *trans, Address *from)
 {
-	/*
-	 * Implement this
-	 */
-    auto transID = ++g_transID;
-
-	transInfo tInfo;
-
-	tInfo.type = READ;
-	tInfo.key = key;
-	tInfo.value = "";
-	tInfo.timestamp = par->getcurrtime();
-	tInfo.numSucc = 0;
-	tInfo.numFail = 0;
-
-    acks[transID] = tInfo; 
+	int position = -1;
 
-    auto replicas = findNodes(key);
-
-    for (int index = 0; index < replicas.size(); ++index) 
+	for (int index = 0; index < trans->asked.count; ++index)
 	{
-		auto replica = replicas[index];
-
-		Message m(transID, 
-		          memberNode->addr, 
-				  READ, 
-				  key);
-
-        string data(m.toString());
+		if (trans->asked.nodes[index] == *from)
+		{
+			if (par->HEDGED_READS && !(trans->answered & (1u << index)))
+			{
+				recordLatency(from, par->getcurrtime() - trans->sentAt[index], true);
+			}
+			trans->answered |= 1u << index;
+			position = index;
+		}
+	}
 
-	    int size = emulNet->ENsend(&memberNode->addr, 
-		                           replica.getAddress(),
-								   (char *)data.c_str(),
-								   (int)data.length());
+	if (par->HINTED_HANDOFF)
+	{
+		suspects.erase(*(int *)(&from->addr));
 	}
+	return position;
 }
 
 /**
- * FUNCTION NAME: clientUpdate
+ * FUNCTION NAME: readRepair
  *
- * DESCRIPTION: client side UPDATE API
- * 				The function does the following:
- * 				1) Constructs the message
- * 				2) Finds the replicas of this key
- * 				3) Sends a message to the replica
+ * DESCRIPTION: After a successful read, send the newest value seen to every replica
+ * 				that answered with an older version or without the key. The repair
+ * 				is a hint addressed to the replica itself, which keeps the version
+ * 				and never overwrites a newer one. Failed reads repair nothing, so a
+ * 				key deleted on a quorum is not brought back from a stale replica.
  */
-void MP2Node::clientUpdate(string key, string value)
+void MP2Node::readRepair(transInfo *trans)
 {
-	/*
-	 * Implement this
-	 */
-    auto transID = ++g_transID;
-
-	transInfo tInfo;
-
-	tInfo.type = UPDATE;
-	tInfo.key = key;
-	tInfo.value = value;
-	tInfo.timestamp = par->getcurrtime();
-	tInfo.numSucc = 0;
-	tInfo.numFail = 0;
+	transInfo &tInfo = *trans;
 
-    acks[transID] = tInfo; 
-
-    auto replicas = findNodes(key);
+	if (!par->READ_REPAIR || tInfo.type != READ || !tInfo.succeeded)
+	{
+		return;
+	}
 
-    for (int index = 0; index < replicas.size(); ++index) 
+	for (int index = 0; index < tInfo.asked.count; ++index)
 	{
-		auto replica = replicas[index];
+		if (!(tInfo.answered & (1u << index)) || tInfo.versions[index] >= tInfo.newestVersion)
+		{
+			continue;
+		}
 
-		Message m(transID, 
-		          memberNode->addr, 
-				  UPDATE, 
-				  key, 
-				  value, 
-				  GetReplicaType(index));
+		// transID 0: repairs are not logged
+		Message m(0, memberNode->addr, tInfo.key, tInfo.newest, GetReplicaType(index),
+				  tInfo.asked.nodes[index], UPDATE, tInfo.newestVersion);
 
-        string data(m.toString());
+		m.expiry = tInfo.expiry;
 
-	    int size = emulNet->ENsend(&memberNode->addr, 
-		                           replica.getAddress(),
-								   (char *)data.c_str(),
-								   (int)data.length());
+		string data(m.toString());
+
+		emulNet->ENsend(&memberNode->addr,
+						&tInfo.asked.nodes[index],
+						(char *)data.c_str(),
+						(int)data.length());
 	}
 }
 
 /**
- * FUNCTION NAME: clientDelete
+ * FUNCTION NAME: suspectSilent
  *
- * DESCRIPTION: client side DELETE API
- * 				The function does the following:
- * 				1) Constructs the message
- * 				2) Finds the replicas of this key
- * 				3) Sends a message to the replica
+ * DESCRIPTION: Suspect every node the timed out transaction went to that did not answer
  */
-void MP2Node::clientDelete(string key)
+void MP2Node::suspectSilent(transInfo *trans)
 {
-	/*
-	 * Implement this
-	 */
-    auto transID = ++g_transID;
-
-	transInfo tInfo;
-
-	tInfo.type = DELETE;
-	tInfo.key = key;
-	tInfo.value = "";
-	tInfo.timestamp = par->getcurrtime();
-	tInfo.numSucc = 0;
-	tInfo.numFail = 0;
-
-    acks[transID] = tInfo; 
-
-    auto replicas = findNodes(key);
-
-    for (int index = 0; index < replicas.size(); ++index) 
+	if (!par->HINTED_HANDOFF)
 	{
-		auto replica = replicas[index];
+		return;
+	}
 
-		Message m(transID, 
-		          memberNode->addr, 
-				  DELETE, 
-				  key);
+	for (int index = 0; index < trans->asked.count; ++index)
+	{
+		if ((trans->sent & ~trans->answered) & (1u << index))
+		{
+			suspects[*(int *)(&trans->asked.nodes[index].addr)] = par->getcurrtime() + SUSPECT_TIME;
+		}
+	}
+}
 
-        string data(m.toString());
+/**
+ * FUNCTION NAME: isSuspect
+ *
+ * DESCRIPTION: Returns true if addr recently missed a reply
+ */
+bool MP2Node::isSuspect(Address *addr)
+{
+	auto it = suspects.find(*(int *)(&addr->addr));
 
-	    int size = emulNet->ENsend(&memberNode->addr, 
-		                           replica.getAddress(),
-								   (char *)data.c_str(),
-								   (int)data.length());
+	if (it == suspects.end())
+	{
+		return false;
+	}
+	if (it->second <= par->getcurrtime())
+	{
+		suspects.erase(it);
+		return false;
 	}
+	return true;
 }
 
 /**
- * FUNCTION NAME: createKeyValue
+ * FUNCTION NAME: recordLatency
  *
- * DESCRIPTION: Server side CREATE API
- * 			   	The function does the following:
- * 			   	1) Inserts key value into the local hash table
- * 			   	2) Return true or false based on success or failure
+ * DESCRIPTION: Fold a reply time of a node into its average. sample also keeps it
+ * 				for the hedge deadline.
  */
-bool MP2Node::createKeyValue(string key, string value, ReplicaType replica)
+void MP2Node::recordLatency(Address *from, int latency, bool sample)
 {
-	/*
-	 * Implement this
-	 */
-	// Insert key, value, replicaType into the hash table
-	Entry e(value, par->getcurrtime(), replica);
+	auto it = latencies.find(*(int *)(&from->addr));
+
+	if (it == latencies.end())
+	{
+		latencies[*(int *)(&from->addr)] = latency;
+	}
+	else
+	{
+		it->second += LATENCY_WEIGHT * (latency - it->second);
+	}
+
+	if (!sample)
+	{
+		return;
+	}
 
-	return ht->create(key, e.convertToString());
+	if (latencySamples.size() < LATENCY_SAMPLES)
+	{
+		latencySamples.push_back(latency);
+	}
+	else
+	{
+		latencySamples[nextSample] = latency;
+		nextSample = (nextSample + 1) % LATENCY_SAMPLES;
+	}
 }
 
 /**
- * FUNCTION NAME: readKey
+ * FUNCTION NAME: hedgeDelay
  *
- * DESCRIPTION: Server side READ API
- * 			    This function does the following:
- * 			    1) Read key from local hash table
- * 			    2) Return value
+ * DESCRIPTION: Returns the ticks a hedged read waits for its first replicas: the
+ * 				HEDGE_PERCENTILE of the recent reply times, TRANS_TIMEOUT before
+ * 				any reply was seen
  */
-string MP2Node::readKey(string key)
+int MP2Node::hedgeDelay()
 {
-	/*
-	 * Implement this
-	 */
-	// Read key from local hash table and return value
-    string entryStr = ht->read(key);
+	if (latencySamples.empty())
+	{
+		return TRANS_TIMEOUT;
+	}
 
-	if (entryStr == "") return entryStr;
+	vector<int> samples(latencySamples);
+	size_t rank = min(samples.size() - 1, samples.size() * max(0, par->HEDGE_PERCENTILE) / 100);
 
-	Entry e(entryStr);
-	
-	return e.value;
+	nth_element(samples.begin(), samples.begin() + rank, samples.end());
+	return max(1, samples[rank]);
 }
 
 /**
- * FUNCTION NAME: updateKeyValue
+ * FUNCTION NAME: rankReplicas
  *
- * DESCRIPTION: Server side UPDATE API
- * 				This function does the following:
- * 				1) Update the key to the new value in the local hash table
- * 				2) Return true or false based on success or failure
+ * DESCRIPTION: Order the indices of replicas with the nodes not suspected first
+ * 				and, with HEDGED_READS, the fastest on average first. A node not
+ * 				heard from yet counts as fast so that it is tried.
  */
-bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica)
+void MP2Node::rankReplicas(ReplicaSet &replicas, int order[])
 {
-	/*
-	 * Implement this
-	 */
-	// Update key in local hash table and return true or false
-	Entry e(value, par->getcurrtime(), replica);
+	double latency[MAX_REPLICAS];
+	bool suspect[MAX_REPLICAS];
+
+	for (int index = 0; index < replicas.count; ++index)
+	{
+		auto it = latencies.find(*(int *)(&replicas.nodes[index].addr));
+
+		order[index] = index;
+		latency[index] = par->HEDGED_READS && it != latencies.end() ? it->second : 0;
+		suspect[index] = isSuspect(&replicas.nodes[index]);
+	}
 
-	return ht->update(key, e.convertToString());
+	stable_sort(order, order + replicas.count,
+				[&](int a, int b) { return suspect[a] != suspect[b] ? suspect[b] : latency[a] < latency[b]; });
 }
 
 /**
- * FUNCTION NAME: deleteKey
+ * FUNCTION NAME: hedgeRead
  *
- * DESCRIPTION: Server side DELETE API
- * 				This function does the following:
- * 				1) Delete the key from the local hash table
- * 				2) Return true or false based on success or failure
+ * DESCRIPTION: Send a hedged read to the replicas it was not sent to, and give
+ * 				them TRANS_TIMEOUT to answer
  */
-bool MP2Node::deletekey(string key)
+void MP2Node::hedgeRead(transInfo *trans)
 {
-	/*
-	 * Implement this
-	 */
-	// Delete the key from the local hash table
-	return ht->deleteKey(key);
+	transInfo &tInfo = *trans;
+	unsigned int all = (1u << tInfo.asked.count) - 1;
+
+	timeouts.cancel(tInfo.hedgeTimer);
+	tInfo.hedgeTimer = 0;
+	if (tInfo.sent == all)
+	{
+		return;
+	}
+
+	for (int index = 0; index < tInfo.asked.count; ++index)
+	{
+		if (tInfo.sent & (1u << index))
+		{
+			continue;
+		}
+
+		Message m(trans->id, memberNode->addr, READ, tInfo.key);
+
+		string data(m.toString());
+
+		tInfo.sent |= 1u << index;
+		tInfo.valueAsked |= 1u << index;
+		tInfo.sentAt[index] = par->getcurrtime();
+		sendRequest(trans->id, tInfo.asked.nodes[index], data);
+	}
+
+	timeouts.cancel(tInfo.timer);
+	tInfo.timer = timeouts.schedule(par->getcurrtime() + TRANS_TIMEOUT, trans->id);
 }
 
 /**
- * FUNCTION NAME: checkMessages
+ * FUNCTION NAME: findSubstitute
  *
- * DESCRIPTION: This function is the message handler of this node.
- * 				This function does the following:
- * 				1) Pops messages from the queue
- * 				2) Handles the messages according to message types
+ * DESCRIPTION: Find the first node clockwise from keyHash that is neither a replica
+ * 				in owners, nor already in taken, nor suspected
+ *
+ * RETURNS:
+ * true if there is one
  */
-void MP2Node::checkMessages()
+bool MP2Node::findSubstitute(uint64_t keyHash, ReplicaSet &owners, ReplicaSet &taken, Address &substitute)
 {
-	/*
-	 * Implement this. Parts of it are already implemented
-	 */
-	char *data;
-	int size;
-
-	/*
-	 * Declare your local variables here
-	 */
+	size_t n = ring.size();
+	size_t start = lower_bound(ring.begin(), ring.end(), keyHash,
+							   [](Node &node, uint64_t pos) { return node.getHashCode() < pos; }) - ring.begin();
 
-	// dequeue all messages and handle them
-	while (!memberNode->mp2q.empty())
+	for (size_t j = 0; j < n; j++)
 	{
-		/*
-		 * Pop a message from the queue
-		 */
-		data = (char *)memberNode->mp2q.front().elt;
-		size = memberNode->mp2q.front().size;
-		memberNode->mp2q.pop();
+		Address *addr = ring[(start + j) % n].getAddress();
 
-		string message(data, data + size);
+		if (!isReplica(owners, addr) && !isReplica(taken, addr) && !isSuspect(addr))
+		{
+			substitute = *addr;
+			return true;
+		}
+	}
+	return false;
+}
 
-        Message m(message);
-		/*
-		 * Handle the message types here
-		 */
+/**
+ * FUNCTION NAME: sendWrite
+ *
+ * DESCRIPTION: Send a CREATE, UPDATE or DELETE to the replicas of the transaction.
+ * 				With HINTED_HANDOFF a suspected replica is replaced by the next
+ * 				healthy node on the ring, which holds the write as a hint for it.
+ */
+void MP2Node::sendWrite(TransID transID, MessageType type, string key, string value, ReplicaSet &replicas)
+{
+	transInfo *trans = acks.find(transID);
 
-		switch (m.type)
+	for (int index = 0; index < replicas.count; ++index)
+	{
+		Address replica = replicas.nodes[index];
+		Address substitute;
+		string data;
+
+		if (par->HINTED_HANDOFF && isSuspect(&replica) &&
+			findSubstitute(trans->keyHash, replicas, trans->asked, substitute))
 		{
-		case CREATE:
+			Message m(transID, memberNode->addr, key, value, GetReplicaType(index), replica, type, trans->timestamp);
+
+			m.expiry = trans->expiry;
+			data = m.toString();
+			trans->asked.nodes[index] = substitute;
+			replica = substitute;
+		}
+		else if (type == DELETE)
 		{
-			bool success = createKeyValue(m.key,
-										  m.value,
-										  m.replica);
+			Message m(transID, memberNode->addr, DELETE, key);
 
-			if (success)
+			data = m.toString();
+		}
+		else
+		{
+			Message m(transID, memberNode->addr, type, key, value, GetReplicaType(index));
+
+			m.expiry = trans->expiry;
+			data = m.toString();
+		}
+
+		sendRequest(transID, replica, data);
+	}
+}
+
+/**
+ * FUNCTION NAME: sendRequest
+ *
+ * DESCRIPTION: Send a request of a transaction this node coordinates. With
+ * 				REPLICA_WINDOW, at most that many requests of open transactions
+ * 				are on their way to a replica at once; the others wait in order
+ * 				in its window and go out as replies come back or transactions
+ * 				time out, so a burst of requests is spread over the ticks to
+ * 				come rather than overflowing the network.
+ */
+void MP2Node::sendRequest(TransID transID, Address &to, const string &data)
+{
+	if (par->REPLICA_WINDOW <= 0)
+	{
+		emulNet->ENsend(&memberNode->addr,
+						&to,
+						(char *)data.c_str(),
+						(int)data.length());
+		return;
+	}
+
+	ReplicaWindow &window = windows[*(int *)(&to.addr)];
+	transInfo *trans = acks.find(transID);
+
+	if (trans)
+	{
+		trans->held++;
+	}
+	window.addr = to;
+	window.queued.push_back(make_pair(transID, data));
+	flushWindow(window);
+}
+
+/**
+ * FUNCTION NAME: releaseRequest
+ *
+ * DESCRIPTION: Free the place in the window of a replica of the request it
+ * 				answered, and send the next one waiting
+ */
+void MP2Node::releaseRequest(Address &from, TransID transID)
+{
+	map<int, ReplicaWindow>::iterator window = windows.find(*(int *)(&from.addr));
+
+	if (window == windows.end())
+	{
+		return;
+	}
+
+	multiset<TransID>::iterator request = window->second.inflight.find(transID);
+
+	if (request != window->second.inflight.end())
+	{
+		window->second.inflight.erase(request);
+	}
+	flushWindow(window->second);
+}
+
+/**
+ * FUNCTION NAME: flushWindow
+ *
+ * DESCRIPTION: Send the requests waiting in the window of a replica while it
+ * 				has room. Requests of transactions closed since, whether
+ * 				answered or timed out, leave the window first; the waiting
+ * 				requests of closed transactions are dropped.
+ */
+void MP2Node::flushWindow(ReplicaWindow &window)
+{
+	size_t limit = (size_t)par->REPLICA_WINDOW;
+
+	if (window.inflight.size() >= limit)
+	{
+		for (multiset<TransID>::iterator it = window.inflight.begin(); it != window.inflight.end();)
+		{
+			if (acks.find(*it))
 			{
-				logSuccess(CREATE,
-						   false,
-						   m.transID,
-						   m.key,
-						   m.value);
+				++it;
 			}
 			else
 			{
-				logFail(CREATE,
-						false,
-						m.transID,
-						m.key,
-						m.value);
+				window.inflight.erase(it++);
 			}
+		}
+	}
 
-			Message reply(m.transID, this->memberNode->addr, REPLY, success); 
+	while (!window.queued.empty() && window.inflight.size() < limit)
+	{
+		transInfo *trans = acks.find(window.queued.front().first);
+		string data;
 
-			string data(reply.toString());
+		data.swap(window.queued.front().second);
+		window.queued.pop_front();
+		if (!trans)
+		{
+			continue;
+		}
 
-			int size = emulNet->ENsend(&memberNode->addr,
-									   &m.fromAddr,
-									   (char *)data.c_str(),
-									   (int)data.length());
+		trans->held--;
+		trans->lastSent = par->getcurrtime();
+		window.inflight.insert(trans->id);
+		emulNet->ENsend(&memberNode->addr,
+						&window.addr,
+						(char *)data.c_str(),
+						(int)data.length());
+	}
+}
 
-			break;
-		}
-        
-		case READ:
+/**
+ * FUNCTION NAME: flushWindows
+ *
+ * DESCRIPTION: Once a tick, after timeouts, send what waits for a replica whose
+ * 				requests timed out rather than being answered
+ */
+void MP2Node::flushWindows()
+{
+	for (auto &window : windows)
+	{
+		if (!window.second.queued.empty())
 		{
-			string value = readKey(m.key);
+			flushWindow(window.second);
+		}
+	}
+}
 
-			if (value != "")
-			{
-				logSuccess(READ,
-						   false,
-						   m.transID,
-						   m.key,
-						   value); 
-			}
-			else
-			{
-				logFail(READ,
-						false,
-						m.transID,
-						m.key,
-						"");
-			}
+void MP2Node::logSuccess(MessageType msgType,
+						 bool coordinator,
+						 TransID transID,
+						 string key,
+						 string value)
+{
+	if (transID == 0) return;
+
+	switch (msgType)
+	{
+
+	case CREATE:
+	{
+		log->logCreateSuccess(&memberNode->addr,
+							  coordinator,
+							  transID,
+							  key,
+							  value);
+
+		break;
+	}
+
+	case READ:
+	{
+		log->logReadSuccess(&memberNode->addr,
+							coordinator,
+							transID,
+							key,
+							value);
+		
+		break;
+	}
+
+	case UPDATE:
+	{
+		log->logUpdateSuccess(&memberNode->addr,
+							  coordinator,
+							  transID,
+							  key,
+							  value);
+		
+		break;
+	}
+
+	case DELETE:
+	{
+		log->logDeleteSuccess(&memberNode->addr,
+							  coordinator,
+							  transID,
+							  key);
+
+		break;
+	}
+	default:
+		// Replies and background traffic are not client operations
+		break;
+	}
+}
+
+void MP2Node::logFail(MessageType msgType,
+					  bool coordinator,
+					  TransID transID,
+					  string key,
+					  string value)
+{
+	if (transID == 0) return;
+
+	switch (msgType)
+	{
+
+	case CREATE:
+	{
+		log->logCreateFail(&memberNode->addr,
+						   coordinator,
+						   transID,
+						   key,
+						   value);
+
+		break;
+	}
+
+	case READ:
+	{
+		log->logReadFail(&memberNode->addr,
+						 coordinator,
+						 transID,
+						 key);
+
+		break;
+	}
+
+	case UPDATE:
+	{
+		log->logUpdateFail(&memberNode->addr,
+						   coordinator,
+						   transID,
+						   key,
+						   value);
+
+		break;
+	}
+
+	case DELETE:
+	{
+		log->logDeleteFail(&memberNode->addr,
+						   coordinator,
+						   transID,
+						   key);
+
+		break;
+	}
+	default:
+		// Replies and background traffic are not client operations
+		break;
+	}
+}
+
+/**
+ * FUNCTION NAME: clientCreate
+ *
+ * DESCRIPTION: client side CREATE API at WRITE_CONSISTENCY
+ */
+OpHandle MP2Node::clientCreate(string key, string value)
+{
+	return clientCreate(key, value, par->WRITE_CONSISTENCY);
+}
+
+/**
+ * FUNCTION NAME: clientCreate
+ *
+ * DESCRIPTION: client side CREATE API
+ * 				The function does the following:
+ * 				1) Constructs the message
+ * 				2) Finds the replicas of this key
+ * 				3) Sends a message to the replica
+ * 				It waits for the replies the given consistency level asks for.
+ */
+OpHandle MP2Node::clientCreate(string key, string value, ConsistencyLevel level)
+{
+	return clientCreate(key, value, level, 0);
+}
+
+/**
+ * FUNCTION NAME: clientCreate
+ *
+ * DESCRIPTION: client side CREATE API of a key that expires ttl ticks after
+ * 				the write, or never if ttl is 0
+ */
+OpHandle MP2Node::clientCreate(string key, string value, ConsistencyLevel level, int ttl)
+{
+	ReplicaSet replicas;
+	TransID transID = startTransaction(CREATE, key, value, level, replicas);
+	transInfo *trans = acks.find(transID);
+	OpHandle handle = handleOf(transID, CREATE, key);
+
+	if (trans && ttl > 0)
+	{
+		trans->expiry = trans->timestamp + ttl;
+	}
+	sendWrite(transID, CREATE, key, value, replicas);
+	return handle;
+}
+
+/**
+ * FUNCTION NAME: clientRead
+ *
+ * DESCRIPTION: client side READ API at READ_CONSISTENCY
+ */
+OpHandle MP2Node::clientRead(string key)
+{
+	return clientRead(key, par->READ_CONSISTENCY);
+}
+
+/**
+ * FUNCTION NAME: clientRead
+ *
+ * DESCRIPTION: client side READ API
+ * 				The function does the following:
+ * 				1) Constructs the message
+ * 				2) Finds the replicas of this key
+ * 				3) Sends a message to the replica
+ * 				It waits for the replies the given consistency level asks for.
+ */
+OpHandle MP2Node::clientRead(string key, ConsistencyLevel level)
+{
+	ReplicaSet replicas;
+	TransID transID = startTransaction(READ, key, "", level, replicas);
+	transInfo *trans = acks.find(transID);
+	OpHandle handle = handleOf(transID, READ, key);
+	int order[MAX_REPLICAS];
+	int fullIndex = -1;
+	int count = replicas.count;
+
+	if (!trans)
+	{
+		// Failed at once, the pending table is full
+		return handle;
+	}
+
+	rankReplicas(replicas, order);
+
+	if (par->DIGEST_READS && replicas.count > 0)
+	{
+		// The value comes from the first replica not known to be down
+		fullIndex = order[0];
+		trans->fullIndex = fullIndex;
+	}
+
+	if (par->HEDGED_READS && trans->needed < replicas.count)
+	{
+		// Only as many replicas as the level needs; the rest are sent the read
+		// if these are late or one of them misses the key
+		int delay = hedgeDelay();
+
+		count = trans->needed;
+		trans->sent = 0;
+		for (int rank = 0; rank < count; ++rank)
+		{
+			trans->sent |= 1u << order[rank];
+		}
+
+		trans->hedgeTimer = timeouts.schedule(trans->timestamp + delay, -transID);
+		timeouts.cancel(trans->timer);
+		trans->timer = timeouts.schedule(trans->timestamp + delay + TRANS_TIMEOUT, transID);
+	}
+
+    for (int rank = 0; rank < count; ++rank) 
+	{
+		int index = order[rank];
+		Address replica = replicas.nodes[index];
+
+		Message m(transID, 
+		          memberNode->addr, 
+				  fullIndex == -1 || index == fullIndex ? READ : DIGEST, 
+				  key);
+
+        string data(m.toString());
+
+		if (m.type == READ)
+		{
+			trans->valueAsked |= 1u << index;
+		}
+		sendRequest(transID, replica, data);
+	}
+
+	return handle;
+}
+
+/**
+ * FUNCTION NAME: valueDigest
+ *
+ * DESCRIPTION: Digest a replica answers a DIGEST read with
+ *
+ * RETURNS:
+ * 0 for a missing key, never 0 otherwise
+ */
+uint64_t MP2Node::valueDigest(const string &value)
+{
+	return value != "" ? ringHash(value) | 1 : 0;
+}
+
+/**
+ * FUNCTION NAME: fetchValue
+ *
+ * DESCRIPTION: Ask a node that sent a digest for the value itself
+ */
+void MP2Node::fetchValue(transInfo *trans, int index)
+{
+	Message m(trans->id, memberNode->addr, READ, trans->key);
+
+	string data(m.toString());
+
+	trans->fetching |= 1u << index;
+	trans->valueAsked |= 1u << index;
+	sendRequest(trans->id, trans->asked.nodes[index], data);
+}
+
+/**
+ * FUNCTION NAME: checkDigests
+ *
+ * DESCRIPTION: Count the digests of a digest read against the values received.
+ * 				A digest of the newest value, or of an older version, which read
+ * 				repair then fixes, is a success; a missing key is a failure. A
+ * 				different value with a newer version makes the coordinator fetch
+ * 				that value. When only the node asked for the value is left to
+ * 				answer, the newest digest is fetched at the end of the tick if
+ * 				the value has not come by then (fetchLateValues).
+ */
+void MP2Node::checkDigests(transInfo *trans)
+{
+	transInfo &tInfo = *trans;
+
+	if (!tInfo.haveFull)
+	{
+		unsigned int others = tInfo.sent & ~(1u << tInfo.fullIndex);
+		int newest = -1;
+
+		// Wait for the value unless only the node asked for it is still silent
+		if (tInfo.fetching || (tInfo.digested & others) != others)
+		{
+			return;
+		}
+
+		for (int index = 0; index < tInfo.asked.count; ++index)
+		{
+			if ((others & (1u << index)) && tInfo.digests[index] != 0 &&
+				(newest == -1 || tInfo.versions[index] > tInfo.versions[newest]))
+			{
+				newest = index;
+			}
+		}
+
+		if (newest != -1)
+		{
+			lateValues.push_back(trans->id);
+			return;
+		}
+		// No node has the key
+	}
+
+	for (int index = 0; index < tInfo.asked.count; ++index)
+	{
+		unsigned int bit = 1u << index;
+
+		if (!(tInfo.digested & bit) || (tInfo.counted & bit) || (tInfo.fetching & bit))
+		{
+			continue;
+		}
+
+		if (tInfo.digests[index] == 0)
+		{
+			tInfo.numFail++;
+			tInfo.counted |= bit;
+		}
+		else if (tInfo.haveFull && tInfo.digests[index] == valueDigest(tInfo.newest))
+		{
+			// Same value, the newest version of it is repaired onto the others
+			tInfo.numSucc++;
+			tInfo.counted |= bit;
+			tInfo.newestVersion = max(tInfo.newestVersion, tInfo.versions[index]);
+		}
+		else if (tInfo.haveFull && tInfo.versions[index] <= tInfo.newestVersion)
+		{
+			tInfo.numSucc++;
+			tInfo.counted |= bit;
+		}
+		else if (tInfo.haveFull)
+		{
+			fetchValue(trans, index);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: fetchLateValues
+ *
+ * DESCRIPTION: Fetch the value of the digest reads whose digests all came this
+ * 				tick but whose value did not, from the node with the newest version
+ */
+void MP2Node::fetchLateValues()
+{
+	for (TransID transID : lateValues)
+	{
+		transInfo *trans = acks.find(transID);
+
+		if (!trans || trans->decided || trans->haveFull || trans->fetching)
+		{
+			continue;
+		}
+
+		int newest = -1;
+
+		for (int index = 0; index < trans->asked.count; ++index)
+		{
+			if ((trans->digested & (1u << index)) && trans->digests[index] != 0 &&
+				(newest == -1 || trans->versions[index] > trans->versions[newest]))
+			{
+				newest = index;
+			}
+		}
+
+		if (newest != -1)
+		{
+			fetchValue(trans, newest);
+		}
+	}
+	lateValues.clear();
+}
+
+/**
+ * FUNCTION NAME: clientUpdate
+ *
+ * DESCRIPTION: client side UPDATE API at WRITE_CONSISTENCY
+ */
+OpHandle MP2Node::clientUpdate(string key, string value)
+{
+	return clientUpdate(key, value, par->WRITE_CONSISTENCY);
+}
+
+/**
+ * FUNCTION NAME: clientUpdate
+ *
+ * DESCRIPTION: client side UPDATE API
+ * 				The function does the following:
+ * 				1) Constructs the message
+ * 				2) Finds the replicas of this key
+ * 				3) Sends a message to the replica
+ * 				It waits for the replies the given consistency level asks for.
+ */
+OpHandle MP2Node::clientUpdate(string key, string value, ConsistencyLevel level)
+{
+	return clientUpdate(key, value, level, 0);
+}
+
+/**
+ * FUNCTION NAME: clientUpdate
+ *
+ * DESCRIPTION: client side UPDATE API giving the key a new time to live of
+ * 				ttl ticks, or none if ttl is 0
+ */
+OpHandle MP2Node::clientUpdate(string key, string value, ConsistencyLevel level, int ttl)
+{
+	ReplicaSet replicas;
+	TransID transID = startTransaction(UPDATE, key, value, level, replicas);
+	transInfo *trans = acks.find(transID);
+	OpHandle handle = handleOf(transID, UPDATE, key);
+
+	if (trans && ttl > 0)
+	{
+		trans->expiry = trans->timestamp + ttl;
+	}
+	sendWrite(transID, UPDATE, key, value, replicas);
+	return handle;
+}
+
+/**
+ * FUNCTION NAME: clientDelete
+ *
+ * DESCRIPTION: client side DELETE API at WRITE_CONSISTENCY
+ */
+OpHandle MP2Node::clientDelete(string key)
+{
+	return clientDelete(key, par->WRITE_CONSISTENCY);
+}
+
+/**
+ * FUNCTION NAME: clientDelete
+ *
+ * DESCRIPTION: client side DELETE API
+ * 				The function does the following:
+ * 				1) Constructs the message
+ * 				2) Finds the replicas of this key
+ * 				3) Sends a message to the replica
+ * 				It waits for the replies the given consistency level asks for.
+ */
+OpHandle MP2Node::clientDelete(string key, ConsistencyLevel level)
+{
+	ReplicaSet replicas;
+	TransID transID = startTransaction(DELETE, key, "", level, replicas);
+	OpHandle handle = handleOf(transID, DELETE, key);
+
+	sendWrite(transID, DELETE, key, "", replicas);
+	return handle;
+}
+
+/**
+ * FUNCTION NAME: multiPut
+ *
+ * DESCRIPTION: client side batched CREATE API at WRITE_CONSISTENCY
+ */
+vector<OpHandle> MP2Node::multiPut(const map<string, string> &pairs)
+{
+	return multiPut(pairs, par->WRITE_CONSISTENCY);
+}
+
+/**
+ * FUNCTION NAME: multiPut
+ *
+ * DESCRIPTION: client side batched CREATE API
+ */
+vector<OpHandle> MP2Node::multiPut(const map<string, string> &pairs, ConsistencyLevel level)
+{
+	vector<string> keys;
+	vector<string> values;
+
+	for (auto &pair : pairs)
+	{
+		keys.push_back(pair.first);
+		values.push_back(pair.second);
+	}
+
+	return startBatch(CREATE, keys, values, level);
+}
+
+/**
+ * FUNCTION NAME: multiGet
+ *
+ * DESCRIPTION: client side batched READ API at READ_CONSISTENCY
+ */
+vector<OpHandle> MP2Node::multiGet(const vector<string> &keys)
+{
+	return multiGet(keys, par->READ_CONSISTENCY);
+}
+
+/**
+ * FUNCTION NAME: multiGet
+ *
+ * DESCRIPTION: client side batched READ API
+ */
+vector<OpHandle> MP2Node::multiGet(const vector<string> &keys, ConsistencyLevel level)
+{
+	return startBatch(READ, keys, vector<string>(keys.size()), level);
+}
+
+/**
+ * FUNCTION NAME: multiDelete
+ *
+ * DESCRIPTION: client side batched DELETE API at WRITE_CONSISTENCY
+ */
+vector<OpHandle> MP2Node::multiDelete(const vector<string> &keys)
+{
+	return multiDelete(keys, par->WRITE_CONSISTENCY);
+}
+
+/**
+ * FUNCTION NAME: multiDelete
+ *
+ * DESCRIPTION: client side batched DELETE API
+ */
+vector<OpHandle> MP2Node::multiDelete(const vector<string> &keys, ConsistencyLevel level)
+{
+	return startBatch(DELETE, keys, vector<string>(keys.size()), level);
+}
+
+/**
+ * FUNCTION NAME: startBatch
+ *
+ * DESCRIPTION: Open one transaction for type on every key, group the keys by
+ * 				replica node and send each node its keys in as few BATCH frames
+ * 				as MAX_MSG_SIZE allows. Batches go straight to the replicas: no hinted handoff, read
+ * 				repair, digests or hedging.
+ *
+ * RETURNS:
+ * a handle per key, in the order of keys
+ */
+vector<OpHandle> MP2Node::startBatch(MessageType type, const vector<string> &keys, const vector<string> &values, ConsistencyLevel level)
+{
+	transInfo *trans = keys.empty() ? NULL : acks.open();
+	map<int, vector<string> > fields;
+	map<int, size_t> frameBytes;
+	map<int, int> frames;
+	map<int, Address> nodes;
+	vector<OpHandle> handles;
+	size_t limit = (size_t)max(par->MAX_MSG_SIZE - LOAD_FRAME_SLACK, 1);
+	int nextFrame = 0;
+
+	if (!trans)
+	{
+		// Every slot waits on a transaction already
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			logFail(type, true, 0, keys[i], values[i]);
+			handles.push_back(newHandle(0, type, keys[i]));
+			completeOp(handles.back(), false, "", -1);
+		}
+		return handles;
+	}
+
+	trans->type = type;
+	trans->timestamp = par->getcurrtime();
+	trans->newestVersion = -1;
+	trans->fullIndex = -1;
+	trans->batch.resize(keys.size());
+	trans->batchLeft = (int)keys.size();
+	trans->timer = timeouts.schedule(trans->timestamp + TRANS_TIMEOUT, trans->id);
+
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		BatchKey &batchKey = trans->batch[i];
+		ReplicaSet replicas;
+		// the key, value and replica type, and their delimiters
+		size_t bytes = keys[i].size() + values[i].size() + 7;
+
+		firstReplicas(replicaTable.lookup(hashFunction(keys[i])), replicationFactor(keys[i]), replicas);
+		batchKey.key = keys[i];
+		batchKey.value = values[i];
+		batchKey.replicas = replicas.count;
+		batchKey.needed = requiredReplies(level, replicas.count);
+		batchKey.newestVersion = -1;
+		batchKey.handle = newHandle(trans->id, type, keys[i]);
+		handles.push_back(batchKey.handle);
+
+		for (int index = 0; index < replicas.count; ++index)
+		{
+			int id = *(int *)(&replicas.nodes[index].addr);
+			vector<string> &nodeFields = fields[id];
+
+			if (!nodeFields.empty() && frameBytes[id] + bytes > limit)
+			{
+				sendBatchFrame(trans, nodes[id], nodeFields);
+			}
+			if (nodeFields.empty())
+			{
+				frames[id] = nextFrame++;
+				trans->batchFrames[frames[id]].node = id;
+				nodeFields.push_back(to_string(type));
+				nodeFields.push_back(to_string(frames[id]));
+				nodes[id] = replicas.nodes[index];
+				frameBytes[id] = 0;
+			}
+			nodeFields.push_back(keys[i]);
+			nodeFields.push_back(values[i]);
+			nodeFields.push_back(to_string(GetReplicaType(index)));
+			trans->batchFrames[frames[id]].keys.push_back((int)i);
+			frameBytes[id] += bytes;
+		}
+	}
+
+	for (auto &node : fields)
+	{
+		if (!node.second.empty())
+		{
+			sendBatchFrame(trans, nodes[node.first], node.second);
+		}
+	}
+
+	return handles;
+}
+
+/**
+ * FUNCTION NAME: sendBatchFrame
+ *
+ * DESCRIPTION: Send the BATCH frame of a node and empty it
+ */
+void MP2Node::sendBatchFrame(transInfo *trans, Address &to, vector<string> &fields)
+{
+	BatchFrame &frame = trans->batchFrames[stoi(fields[1])];
+	Message m(trans->id, memberNode->addr, BATCH, fields);
+
+	frame.left = (int)frame.keys.size();
+	frame.answered.assign(frame.keys.size(), false);
+	fields.clear();
+	sendRequest(trans->id, to, m.toString());
+}
+
+/**
+ * FUNCTION NAME: decideBatchKey
+ *
+ * DESCRIPTION: Log a key of a batch once enough of its replicas succeeded for the
+ * 				level, or so many failed that it can no longer succeed, and close
+ * 				the batch once every key is logged
+ */
+void MP2Node::decideBatchKey(transInfo *trans, int index)
+{
+	BatchKey &batchKey = trans->batch[index];
+
+	if (batchKey.decided)
+	{
+		return;
+	}
+
+	if (batchKey.numSucc >= batchKey.needed)
+	{
+		string value = trans->type == READ ? batchKey.newest : batchKey.value;
+
+		logSuccess(trans->type,
+				   true,
+				   trans->id,
+				   batchKey.key,
+				   value);
+		completeOp(batchKey.handle, true, value, batchKey.newestVersion);
+	}
+	else if (batchKey.numFail >= batchKey.replicas - batchKey.needed + 1)
+	{
+		logFail(trans->type,
+				true,
+				trans->id,
+				batchKey.key,
+				batchKey.value);
+		completeOp(batchKey.handle, false, "", -1);
+	}
+	else
+	{
+		return;
+	}
+
+	batchKey.decided = true;
+	if (--trans->batchLeft == 0)
+	{
+		// Frames still held in replica windows keep it open until they go out
+		closeTransaction(trans);
+	}
+}
+
+/**
+ * FUNCTION NAME: serveBatch
+ *
+ * DESCRIPTION: Server side of a BATCH: apply the operation to every key as its
+ * 				single key message would, and answer them in as few BATCHREPLY
+ * 				messages as MAX_MSG_SIZE allows, each naming the frame and the
+ * 				position in it of its first key
+ */
+void MP2Node::serveBatch(Message &m)
+{
+	if (m.fields.size() < 2)
+	{
+		return;
+	}
+
+	MessageType type = static_cast<MessageType>(stoi(m.fields[0]));
+	size_t limit = (size_t)max(par->MAX_MSG_SIZE - LOAD_FRAME_SLACK, 1);
+	vector<string> results;
+	size_t bytes = 0;
+	int position = 0;
+
+	for (size_t i = 2; i + 2 < m.fields.size(); i += 3, ++position)
+	{
+		string &key = m.fields[i];
+		string value = m.fields[i + 1];
+		ReplicaType replica = static_cast<ReplicaType>(stoi(m.fields[i + 2]));
+		// a write is versioned with the time it is applied
+		int timestamp = par->getcurrtime();
+		bool success;
+
+		switch (type)
+		{
+		case CREATE:
+			success = createKeyValue(key, value, replica);
+			break;
+		case UPDATE:
+			success = updateKeyValue(key, value, replica);
+			break;
+		case READ:
+			value = readKey(key, timestamp);
+			success = value != "";
+			break;
+		case DELETE:
+		default:
+			success = deletekey(key);
+			break;
+		}
+
+		if (success)
+		{
+			logSuccess(type, false, m.transID, key, value);
+		}
+		else
+		{
+			logFail(type, false, m.transID, key, value);
+		}
+
+		string result = type == READ ? value : "";
+		string version = to_string(timestamp);
+		// the three fields and their delimiters
+		size_t size = result.size() + version.size() + 7;
+
+		if (!results.empty() && bytes + size > limit)
+		{
+			sendBatchReply(m, results);
+		}
+		if (results.empty())
+		{
+			results.push_back(m.fields[1]);
+			results.push_back(to_string(position));
+			bytes = 0;
+		}
+		results.push_back(success ? "1" : "0");
+		results.push_back(result);
+		results.push_back(version);
+		bytes += size;
+	}
+
+	if (!results.empty())
+	{
+		sendBatchReply(m, results);
+	}
+}
+
+/**
+ * FUNCTION NAME: sendBatchReply
+ *
+ * DESCRIPTION: Send one BATCHREPLY to the coordinator of the BATCH and empty it
+ */
+void MP2Node::sendBatchReply(Message &m, vector<string> &results)
+{
+	Message reply(m.transID, memberNode->addr, BATCHREPLY, results);
+
+	string data(reply.toString());
+
+	results.clear();
+	emulNet->ENsend(&memberNode->addr,
+					&m.fromAddr,
+					(char *)data.c_str(),
+					(int)data.length());
+}
+
+/**
+ * FUNCTION NAME: recvBatchReply
+ *
+ * DESCRIPTION: Count the results of a node for the keys of a batch frame it was
+ * 				sent. An unreadable reply fails the keys of the frame not
+ * 				answered yet. The frame leaves the replica window once all of
+ * 				its keys are answered, or its transaction is closed.
+ */
+void MP2Node::recvBatchReply(Message &m)
+{
+	transInfo *trans = acks.find(m.transID);
+	map<int, BatchFrame>::iterator frame;
+
+	if (!trans || trans->batch.empty() || m.fields.size() < 2 ||
+		(frame = trans->batchFrames.find(stoi(m.fields[0]))) == trans->batchFrames.end() ||
+		frame->second.node != *(int *)(&m.fromAddr.addr))
+	{
+		releaseRequest(m.fromAddr, m.transID);
+		return;
+	}
+
+	BatchFrame &keys = frame->second;
+	size_t first = (size_t)stoi(m.fields[1]);
+
+	if ((m.fields.size() - 2) % 3 != 0 || first + (m.fields.size() - 2) / 3 > keys.keys.size())
+	{
+		// Unreadable: the keys of the frame not answered yet count as failed
+		for (size_t position = 0; position < keys.keys.size(); ++position)
+		{
+			if (keys.answered[position])
+			{
+				continue;
+			}
+			keys.answered[position] = true;
+			trans->batch[keys.keys[position]].numFail++;
+			decideBatchKey(trans, keys.keys[position]);
+			if (!acks.find(m.transID))
+			{
+				break;
+			}
+		}
+		if (acks.find(m.transID))
+		{
+			trans->batchFrames.erase(frame);
+		}
+		releaseRequest(m.fromAddr, m.transID);
+		return;
+	}
+
+	for (size_t i = 2, position = first; i + 2 < m.fields.size(); i += 3, ++position)
+	{
+		// A duplicate reply finds its keys answered
+		if (keys.answered[position])
+		{
+			continue;
+		}
+		keys.answered[position] = true;
+		keys.left--;
+
+		BatchKey &batchKey = trans->batch[keys.keys[position]];
+		int version = stoi(m.fields[i + 2]);
+
+		if (m.fields[i] == "1")
+		{
+			batchKey.numSucc++;
+			if (version > batchKey.newestVersion)
+			{
+				batchKey.newestVersion = version;
+				batchKey.newest = m.fields[i + 1];
+			}
+		}
+		else
+		{
+			batchKey.numFail++;
+		}
+
+		decideBatchKey(trans, keys.keys[position]);
+		if (!acks.find(m.transID))
+		{
+			// Closed
+			releaseRequest(m.fromAddr, m.transID);
+			return;
+		}
+	}
+
+	if (keys.left == 0)
+	{
+		trans->batchFrames.erase(frame);
+		releaseRequest(m.fromAddr, m.transID);
+	}
+}
+
+/**
+ * FUNCTION NAME: clientScan
+ *
+ * DESCRIPTION: Client side range scan. The keys of a token range are one
+ * 				interval of keys when keys are placed in key order, so the scan
+ * 				walks the ranges from the one of start, asking one replica at a
+ * 				time for a page of SCAN_PAGE keys out of the ranges it holds
+ * 				next (scanPage). A page that comes back full is followed by the
+ * 				next one from the same replica, a short one by the ranges after,
+ * 				until limit keys are found or the range of end is done. A page not
+ * 				answered in TRANS_TIMEOUT fails the scan; the handle keeps the
+ * 				rows found until then.
+ */
+OpHandle MP2Node::clientScan(string start, string end, int limit)
+{
+	ReplicaSet replicas;
+
+	if (!par->ORDERED_PARTITIONER || limit <= 0)
+	{
+		// Keys placed by hash are in no order to scan
+		OpHandle handle = newHandle(0, SCAN, start);
+
+		completeOp(handle, false, "", -1);
+		return handle;
+	}
+
+	TransID transID = startTransaction(SCAN, start, end, ONE, replicas);
+	transInfo *trans = acks.find(transID);
+	OpHandle handle = handleOf(transID, SCAN, start);
+
+	if (!trans)
+	{
+		return handle;
+	}
+
+	trans->scanFrom = start;
+	trans->scanAfter = false;
+	trans->scanEnd = end;
+	trans->scanLeft = limit;
+	trans->scanLo = trans->keyHash;
+	scanPage(trans);
+
+	return handle;
+}
+
+/**
+ * FUNCTION NAME: scanPage
+ *
+ * DESCRIPTION: Ask a replica of the range at scanLo for the next page of a scan.
+ * 				Of the replicas not suspected, the one holding the most ranges
+ * 				in a row from there is asked, the fastest of those first; the
+ * 				page covers all of these ranges.
+ */
+void MP2Node::scanPage(transInfo *trans)
+{
+	ReplicaSet replicas;
+	int order[MAX_REPLICAS];
+	vector<string> fields;
+	int best = -1;
+
+	timeouts.cancel(trans->timer);
+	trans->timer = timeouts.schedule(par->getcurrtime() + TRANS_TIMEOUT, trans->id);
+
+	if (replicaTable.size() == 0)
+	{
+		// Fails on timeout
+		return;
+	}
+
+	// The front replicas hold the keys of every keyspace
+	firstReplicas(replicaTable.lookup(trans->scanLo), minReplicas, replicas);
+	if (replicas.count == 0)
+	{
+		return;
+	}
+	rankReplicas(replicas, order);
+
+	for (int rank = 0; rank < replicas.count; ++rank)
+	{
+		int index = order[rank];
+		uint64_t hi = scanRun(trans, replicas.nodes[index]);
+
+		if (best == -1 || (hi > trans->scanHi && !isSuspect(&replicas.nodes[index])))
+		{
+			best = index;
+			trans->scanHi = hi;
+		}
+	}
+
+	trans->asked = replicas;
+	trans->sent = 1u << best;
+	trans->answered = 0;
+	trans->sentAt[best] = par->getcurrtime();
+
+	fields.push_back(trans->scanFrom);
+	fields.push_back(trans->scanAfter ? "1" : "0");
+	fields.push_back(trans->scanEnd);
+	fields.push_back(to_string(trans->scanLo));
+	fields.push_back(to_string(trans->scanHi));
+	fields.push_back(to_string(min(trans->scanLeft, par->SCAN_PAGE)));
+
+	Message m(trans->id, memberNode->addr, SCAN, fields);
+
+	sendRequest(trans->id, trans->asked.nodes[best], m.toString());
+}
+
+/**
+ * FUNCTION NAME: scanRun
+ *
+ * DESCRIPTION: Follow the ranges from the one at scanLo while replica holds them,
+ * 				up to the range of the end of the scan. The range wrapping
+ * 				around past the last token is scanned up to the end of the ring.
+ *
+ * RETURNS:
+ * the last ring position of the ranges followed
+ */
+uint64_t MP2Node::scanRun(transInfo *trans, Address &replica)
+{
+	size_t count = replicaTable.size();
+	uint64_t end = trans->scanEnd.empty() ? UINT64_MAX : hashFunction(trans->scanEnd);
+	uint64_t hi;
+
+	if (trans->scanLo > replicaTable.token(count - 1))
+	{
+		return UINT64_MAX;
+	}
+
+	hi = replicaTable.token(replicaTable.rangeOf(trans->scanLo));
+	for (size_t range = replicaTable.rangeOf(trans->scanLo) + 1; hi < end && range <= count; ++range)
+	{
+		ReplicaSet front;
+
+		firstReplicas(replicaTable.lookup(range < count ? replicaTable.token(range) : UINT64_MAX),
+					  minReplicas,
+					  front);
+		if (!isReplica(front, &replica))
+		{
+			break;
+		}
+		hi = range < count ? replicaTable.token(range) : UINT64_MAX;
+	}
+	return hi;
+}
+
+/**
+ * FUNCTION NAME: serveScan
+ *
+ * DESCRIPTION: Server side of a SCAN: the keys held from the given key on, in
+ * 				order, that lie in the given ring positions and before the end
+ * 				of the scan, up to the page size or as many as fit in
+ * 				MAX_MSG_SIZE
+ */
+void MP2Node::serveScan(Message &m)
+{
+	if (m.fields.size() < 6)
+	{
+		return;
+	}
+
+	const string &from = m.fields[0];
+	const string &end = m.fields[2];
+	uint64_t lo = stoull(m.fields[3]);
+	uint64_t hi = stoull(m.fields[4]);
+	size_t limit = (size_t)stoi(m.fields[5]);
+	size_t maxBytes = (size_t)max(par->MAX_MSG_SIZE - LOAD_FRAME_SLACK, 1);
+	vector<string> results(1, "0");
+	size_t bytes = 0;
+
+	auto it = m.fields[1] == "1" ? ht->hashTable.upper_bound(from) : ht->hashTable.lower_bound(from);
+
+	for (; it != ht->hashTable.end() && results.size() < 1 + 3 * limit; ++it)
+	{
+		uint64_t pos = hashFunction(it->first);
+		int timestamp;
+
+		if ((!end.empty() && it->first >= end) || pos > hi)
+		{
+			break;
+		}
+		if (pos < lo)
+		{
+			// Of the range before, which its replica scanned already
+			continue;
+		}
+
+		string value = readKey(it->first, timestamp);
+
+		if (value == "")
+		{
+			// Expired, not reclaimed yet
+			continue;
+		}
+
+		string version = to_string(timestamp);
+		// the key, value and version, and their delimiters
+		size_t rowBytes = it->first.size() + value.size() + version.size() + 6;
+
+		if (results.size() > 1 && bytes + rowBytes > maxBytes)
+		{
+			// The page is full by size, the next one starts at this key
+			results[0] = "1";
+			break;
+		}
+		results.push_back(it->first);
+		results.push_back(value);
+		results.push_back(version);
+		bytes += rowBytes;
+	}
+
+	// A full page may have more behind it
+	if (results.size() == 1 + 3 * limit)
+	{
+		results[0] = "1";
+	}
+
+	Message reply(m.transID, memberNode->addr, SCANREPLY, results);
+
+	string data(reply.toString());
+
+	emulNet->ENsend(&memberNode->addr,
+					&m.fromAddr,
+					(char *)data.c_str(),
+					(int)data.length());
+}
+
+/**
+ * FUNCTION NAME: recvScanReply
+ *
+ * DESCRIPTION: Add a page to the rows of a scan and ask for the next one, or
+ * 				complete the scan
+ */
+void MP2Node::recvScanReply(Message &m)
+{
+	transInfo *trans = acks.find(m.transID);
+	int index = trans && trans->type == SCAN && !m.fields.empty() ? recordAnswer(trans, &m.fromAddr) : -1;
+
+	if (index < 0 || !(trans->sent & (1u << index)))
+	{
+		return;
+	}
+
+	for (size_t i = 1; i + 2 < m.fields.size() && trans->scanLeft > 0; i += 3)
+	{
+		trans->handle->rows.push_back(make_pair(m.fields[i], m.fields[i + 1]));
+		trans->scanFrom = m.fields[i];
+		trans->scanAfter = true;
+		trans->scanLeft--;
+	}
+
+	if (trans->scanLeft > 0 && m.fields[0] == "1")
+	{
+		scanPage(trans);
+	}
+	else if (trans->scanLeft > 0 && trans->scanHi != UINT64_MAX &&
+			 (trans->scanEnd.empty() || hashFunction(trans->scanEnd) > trans->scanHi))
+	{
+		trans->scanLo = trans->scanHi + 1;
+		scanPage(trans);
+	}
+	else
+	{
+		trans->succeeded = true;
+		completeOp(trans->handle, true, "", -1);
+		closeTransaction(trans);
+	}
+}
+
+/**
+ * FUNCTION NAME: bulkLoad
+ *
+ * DESCRIPTION: Client side bulk load. Each pair is added to the open frame of
+ * 				every replica of its key, and a frame is shipped once the next
+ * 				pair would take it past MAX_MSG_SIZE. A sorted stream comes to
+ * 				every replica in order, as runs of keys sharing replicas. The
+ * 				load fails if a frame is not acknowledged in TRANS_TIMEOUT; once
+ * 				done its speed, by wall clock, goes to the stats log.
+ */
+OpHandle MP2Node::bulkLoad(const vector<pair<string, string> > &pairs)
+{
+	transInfo *trans = acks.open();
+	map<int, vector<string> > frames;
+	map<int, size_t> frameBytes;
+	map<int, Address> nodes;
+	size_t limit = (size_t)max(par->MAX_MSG_SIZE - LOAD_FRAME_SLACK, 1);
+
+	if (!trans)
+	{
+		// Every slot waits on a transaction already
+		OpHandle handle = newHandle(0, LOAD, "");
+
+		completeOp(handle, false, "", -1);
+		return handle;
+	}
+
+	trans->type = LOAD;
+	trans->key = pairs.empty() ? "" : pairs.front().first;
+	trans->timestamp = par->getcurrtime();
+	trans->newestVersion = -1;
+	trans->fullIndex = -1;
+	trans->loadKeys = (int)pairs.size();
+	trans->loadStart = chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+	trans->handle = newHandle(trans->id, LOAD, trans->key);
+	trans->timer = timeouts.schedule(trans->timestamp + TRANS_TIMEOUT, trans->id);
+
+	for (auto &kv : pairs)
+	{
+		ReplicaSet replicas;
+		// the key, value and replica type, and their delimiters
+		size_t bytes = kv.first.size() + kv.second.size() + 7;
+
+		firstReplicas(replicaTable.lookup(hashFunction(kv.first)), replicationFactor(kv.first), replicas);
+		trans->loadBytes += (long)(kv.first.size() + kv.second.size());
+
+		for (int index = 0; index < replicas.count; ++index)
+		{
+			int id = *(int *)(&replicas.nodes[index].addr);
+			vector<string> &fields = frames[id];
+
+			nodes[id] = replicas.nodes[index];
+			if (!fields.empty() && frameBytes[id] + bytes > limit)
+			{
+				shipFrame(trans, nodes[id], fields);
+				frameBytes[id] = 0;
+			}
+			fields.push_back(kv.first);
+			fields.push_back(kv.second);
+			fields.push_back(to_string(GetReplicaType(index)));
+			frameBytes[id] += bytes;
+		}
+	}
+
+	for (auto &frame : frames)
+	{
+		if (!frame.second.empty())
+		{
+			shipFrame(trans, nodes[frame.first], frame.second);
+		}
+	}
+
+	OpHandle handle = trans->handle;
+
+	if (pairs.empty())
+	{
+		trans->succeeded = true;
+		completeOp(trans->handle, true, "", -1);
+		closeTransaction(trans);
+	}
+	return handle;
+}
+
+/**
+ * FUNCTION NAME: shipFrame
+ *
+ * DESCRIPTION: Send the LOAD frame of a node and empty it
+ */
+void MP2Node::shipFrame(transInfo *trans, Address &to, vector<string> &fields)
+{
+	Message m(trans->id, memberNode->addr, LOAD, fields);
+
+	trans->needed++;
+	fields.clear();
+	sendRequest(trans->id, to, m.toString());
+}
+
+/**
+ * FUNCTION NAME: serveLoad
+ *
+ * DESCRIPTION: Server side of a LOAD: append the keys of the frame to the hash
+ * 				table as a create would, without a log line per key. The frame
+ * 				is sorted, so each key goes in at the end of the table in
+ * 				constant time when none of them is there yet. A key held
+ * 				already, or deleted, keeps the newer of its version and the
+ * 				loaded one, as a write of any other path would. The LOADACK
+ * 				carries the number of keys written.
+ */
+void MP2Node::serveLoad(Message &m)
+{
+	int timestamp = par->getcurrtime();
+	int count = 0;
+
+	for (size_t i = 0; i + 2 < m.fields.size(); i += 3)
+	{
+		const string &key = m.fields[i];
+		ReplicaType replica = static_cast<ReplicaType>(stoi(m.fields[i + 2]));
+
+		if (tombstones.empty() || tombstones.find(key) == tombstones.end())
+		{
+			Entry e(m.fields[i + 1], timestamp, replica);
+			uint64_t before = itemHash(key);
+			size_t size = ht->hashTable.size();
+
+			ht->hashTable.emplace_hint(ht->hashTable.end(), key, e.convertToString());
+			if (ht->hashTable.size() != size)
+			{
+				merkleUpdate(key, before);
+				count++;
+				continue;
+			}
+		}
+
+		// Held already, emplace left it as it was, or deleted
+		if (applyVersion(key, m.fields[i + 1], timestamp, false, replica, 0))
+		{
+			count++;
+		}
+	}
+
+	Message reply(m.transID, memberNode->addr, LOADACK, vector<string>(1, to_string(count)));
+
+	string data(reply.toString());
+
+	emulNet->ENsend(&memberNode->addr,
+					&m.fromAddr,
+					(char *)data.c_str(),
+					(int)data.length());
+}
+
+/**
+ * FUNCTION NAME: recvLoadAck
+ *
+ * DESCRIPTION: Count a frame of a bulk load as stored, and complete the load
+ * 				once all are
+ */
+void MP2Node::recvLoadAck(Message &m)
+{
+	transInfo *trans = acks.find(m.transID);
+
+	if (!trans || trans->type != LOAD || trans->decided || m.fields.empty())
+	{
+		return;
+	}
+
+	trans->numSucc++;
+	trans->loadAcked += stol(m.fields[0]);
+	if (trans->numSucc < trans->needed)
+	{
+		return;
+	}
+
+	double now = chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+	double seconds = max(now - trans->loadStart, 1e-9);
+
+	log->LOG(&memberNode->addr,
+			 "#STATSLOG# bulk load of %d keys, %ld bytes, %ld replica writes in %d frames and %d ticks: %.0f keys/s, %.2f MB/s",
+			 trans->loadKeys,
+			 trans->loadBytes,
+			 trans->loadAcked,
+			 trans->needed,
+			 par->getcurrtime() - trans->timestamp,
+			 trans->loadKeys / seconds,
+			 trans->loadBytes / seconds / 1e6);
+
+	trans->succeeded = true;
+	completeOp(trans->handle, true, "", -1);
+	closeTransaction(trans);
+}
+
+/**
+ * FUNCTION NAME: createKeyValue
+ *
+ * DESCRIPTION: Server side CREATE API
+ * 			   	The function does the following:
+ * 			   	1) Inserts key value into the local hash table
+ * 			   	2) Return true or false based on success or failure
+ */
+bool MP2Node::createKeyValue(string key, string value, ReplicaType replica)
+{
+	/*
+	 * Implement this
+	 */
+	// Insert key, value, replicaType into the hash table
+	return createKeyValue(key, value, replica, 0);
+}
+
+/**
+ * FUNCTION NAME: createKeyValue
+ *
+ * DESCRIPTION: Server side CREATE API of a key that expires at the given time,
+ * 				0 for never. A key whose time to live ran out is reclaimed
+ * 				first, so it can be created again.
+ */
+bool MP2Node::createKeyValue(string key, string value, ReplicaType replica, int expiry)
+{
+	Entry e(value, par->getcurrtime(), replica, expiry);
+
+	expireKey(key);
+
+	uint64_t before = itemHash(key);
+
+	bool success = ht->create(key, e.convertToString());
+	tombstones.erase(key);
+	merkleUpdate(key, before);
+	if (success && expiry != 0)
+	{
+		expiring = true;
+	}
+	return success;
+}
+
+/**
+ * FUNCTION NAME: readKey
+ *
+ * DESCRIPTION: Server side READ API
+ * 			    This function does the following:
+ * 			    1) Read key from local hash table
+ * 			    2) Return value
+ */
+string MP2Node::readKey(string key)
+{
+	/*
+	 * Implement this
+	 */
+	// Read key from local hash table and return value
+	int timestamp;
+
+	return readKey(key, timestamp);
+}
+
+/**
+ * FUNCTION NAME: readKey
+ *
+ * DESCRIPTION: Server side READ API that also returns the version of the value,
+ * 				the time it was written
+ */
+string MP2Node::readKey(string key, int &timestamp)
+{
+	int expiry;
+
+	return readKey(key, timestamp, expiry);
+}
+
+/**
+ * FUNCTION NAME: readKey
+ *
+ * DESCRIPTION: Server side READ API that also returns the version of the value
+ * 				and the time it expires at, 0 for never. A key whose time to
+ * 				live ran out reads as missing.
+ */
+string MP2Node::readKey(string key, int &timestamp, int &expiry)
+{
+	string entryStr = ht->read(key);
+
+	timestamp = 0;
+	expiry = 0;
+	if (entryStr == "") return entryStr;
+
+	Entry e(entryStr);
+
+	if (e.expiredAt(par->getcurrtime())) return "";
+
+	timestamp = e.timestamp;
+	expiry = e.expiry;
+	return e.value;
+}
+
+/**
+ * FUNCTION NAME: updateKeyValue
+ *
+ * DESCRIPTION: Server side UPDATE API
+ * 				This function does the following:
+ * 				1) Update the key to the new value in the local hash table
+ * 				2) Return true or false based on success or failure
+ */
+bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica)
+{
+	/*
+	 * Implement this
+	 */
+	// Update key in local hash table and return true or false
+	return updateKeyValue(key, value, replica, 0);
+}
+
+/**
+ * FUNCTION NAME: updateKeyValue
+ *
+ * DESCRIPTION: Server side UPDATE API giving the key a new time to live, that
+ * 				ends at the given time, 0 for never. A key whose time to live
+ * 				ran out is missing and fails the update.
+ */
+bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica, int expiry)
+{
+	Entry e(value, par->getcurrtime(), replica, expiry);
+
+	expireKey(key);
+
+	uint64_t before = itemHash(key);
+
+	bool success = ht->update(key, e.convertToString());
+	if (success)
+	{
+		tombstones.erase(key);
+		merkleUpdate(key, before);
+		if (expiry != 0)
+		{
+			expiring = true;
+		}
+	}
+	return success;
+}
+
+/**
+ * FUNCTION NAME: deleteKey
+ *
+ * DESCRIPTION: Server side DELETE API
+ * 				This function does the following:
+ * 				1) Delete the key from the local hash table
+ * 				2) Return true or false based on success or failure
+ */
+bool MP2Node::deletekey(string key)
+{
+	/*
+	 * Implement this
+	 */
+	// Delete the key from the local hash table
+	if (expireKey(key))
+	{
+		// Gone already
+		return false;
+	}
+
+	uint64_t before = itemHash(key);
+
+	bool success = ht->deleteKey(key);
+	if (success && par->ANTI_ENTROPY_PERIOD > 0)
+	{
+		// Remembered so anti-entropy does not bring the key back
+		tombstones[key] = par->getcurrtime();
+		merkleUpdate(key, before);
+	}
+	return success;
+}
+
+/**
+ * FUNCTION NAME: expireKey
+ *
+ * DESCRIPTION: Reclaim key if its time to live ran out. It counts as deleted at
+ * 				the version of its last write, so anti-entropy does not bring an
+ * 				older version back.
+ *
+ * RETURNS:
+ * true if the key was reclaimed
+ */
+bool MP2Node::expireKey(const string &key)
+{
+	string entryStr = ht->read(key);
+
+	if (entryStr == "")
+	{
+		return false;
+	}
+
+	Entry e(entryStr);
+
+	if (!e.expiredAt(par->getcurrtime()))
+	{
+		return false;
+	}
+
+	uint64_t before = itemHash(key);
+
+	ht->deleteKey(key);
+	if (par->ANTI_ENTROPY_PERIOD > 0)
+	{
+		tombstones[key] = e.timestamp;
+	}
+	merkleUpdate(key, before);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: sweepExpired
+ *
+ * DESCRIPTION: Look at the next TTL_SWEEP keys in key order, from where the last
+ * 				sweep stopped and around, and reclaim those whose time to live
+ * 				ran out. Keys nobody touches again are freed this way at a
+ * 				bounded cost per tick rather than in one pass over the table.
+ */
+void MP2Node::sweepExpired()
+{
+	size_t count = min((size_t)par->TTL_SWEEP, ht->hashTable.size());
+	auto it = ht->hashTable.lower_bound(sweepFrom);
+
+	for (size_t visited = 0; visited < count; ++visited)
+	{
+		if (it == ht->hashTable.end())
+		{
+			it = ht->hashTable.begin();
+		}
+
+		// Step past the key before it may be erased
+		string key = it->first;
+
+		++it;
+		expireKey(key);
+	}
+
+	sweepFrom = it == ht->hashTable.end() ? "" : it->first;
+}
+
+/**
+ * FUNCTION NAME: checkMessages
+ *
+ * DESCRIPTION: This function is the message handler of this node.
+ * 				This function does the following:
+ * 				1) Pops messages from the queue
+ * 				2) Handles the messages according to message types
+ */
+void MP2Node::checkMessages()
+{
+	/*
+	 * Implement this. Parts of it are already implemented
+	 */
+	char *data;
+	int size;
+
+	/*
+	 * Declare your local variables here
+	 */
+
+	// dequeue all messages and handle them
+	while (!memberNode->mp2q.empty())
+	{
+		/*
+		 * Pop a message from the queue
+		 */
+		data = (char *)memberNode->mp2q.front().elt;
+		size = memberNode->mp2q.front().size;
+		memberNode->mp2q.pop();
+
+		string message(data, data + size);
+
+        Message m(message);
+
+		// A reply to a transaction of this node makes room in the window of
+		// the replica; a batch frame, answered in parts, once it is answered
+		// in full (recvBatchReply)
+		if (par->REPLICA_WINDOW > 0 && m.transID != 0 &&
+			(m.type == REPLY || m.type == READREPLY || m.type == DIGESTREPLY ||
+			 m.type == SCANREPLY || m.type == LOADACK))
+		{
+			releaseRequest(m.fromAddr, m.transID);
+		}
+
+		/*
+		 * Handle the message types here
+		 */
+
+		switch (m.type)
+		{
+		case CREATE:
+		{
+			bool success = createKeyValue(m.key,
+										  m.value,
+										  m.replica,
+										  m.expiry);
+
+			if (success)
+			{
+				logSuccess(CREATE,
+						   false,
+						   m.transID,
+						   m.key,
+						   m.value);
+			}
+			else
+			{
+				logFail(CREATE,
+						false,
+						m.transID,
+						m.key,
+						m.value);
+			}
+
+			Message reply(m.transID, this->memberNode->addr, REPLY, success); 
+
+			// Version of the write
+			reply.timestamp = par->getcurrtime();
+
+			string data(reply.toString());
+
+			int size = emulNet->ENsend(&memberNode->addr,
+									   &m.fromAddr,
+									   (char *)data.c_str(),
+									   (int)data.length());
+
+			break;
+		}
+        
+		case READ:
+		{
+			int timestamp;
+			int expiry;
+			string value = readKey(m.key, timestamp, expiry);
+
+			if (value != "")
+			{
+				logSuccess(READ,
+						   false,
+						   m.transID,
+						   m.key,
+						   value); 
+			}
+			else
+			{
+				logFail(READ,
+						false,
+						m.transID,
+						m.key,
+						"");
+			}
+
+			Message readReply(m.transID, this->memberNode->addr, value, timestamp);
+
+			readReply.expiry = expiry;
+
+			string data(readReply.toString());
+
+			int size = emulNet->ENsend(&memberNode->addr,
+									   &m.fromAddr,
+									   (char *)data.c_str(),
+									   (int)data.length());
+
+			break;
+		}
+
+		case DIGEST:
+		{
+			int timestamp;
+			string value = readKey(m.key, timestamp);
+			vector<string> fields;
+
+			if (value != "")
+			{
+				logSuccess(READ,
+						   false,
+						   m.transID,
+						   m.key,
+						   value);
+			}
+			else
+			{
+				logFail(READ,
+						false,
+						m.transID,
+						m.key,
+						"");
+			}
+
+			fields.push_back(to_string(valueDigest(value)));
+			fields.push_back(to_string(value != "" ? timestamp : -1));
+
+			Message digestReply(m.transID, this->memberNode->addr, DIGESTREPLY, fields);
+
+			string data(digestReply.toString());
+
+			emulNet->ENsend(&memberNode->addr,
+							&m.fromAddr,
+							(char *)data.c_str(),
+							(int)data.length());
+
+			break;
+		}
+
+		case DIGESTREPLY:
+		{
+			transInfo *trans = acks.find(m.transID);
+			int index = trans && m.fields.size() >= 2 ? recordAnswer(trans, &m.fromAddr) : -1;
+
+			if (index < 0)
+			{
+				break;
+			}
+
+			trans->digests[index] = stoull(m.fields[0]);
+			trans->versions[index] = stoi(m.fields[1]);
+			trans->digested |= 1u << index;
+
+			if (!trans->decided)
+			{
+				checkDigests(trans);
+				if (trans->numFail > 0 && trans->hedgeTimer)
+				{
+					hedgeRead(trans);
+				}
+				decideTransaction(trans, trans->newest);
+			}
+			else if (trans->answered == trans->sent)
+			{
+				// Every replica answered a decided read
+				readRepair(trans);
+				timeouts.cancel(trans->timer);
+				acks.close(trans);
+			}
+
+			break;
+		}
+
+		case UPDATE:
+		{
+			bool success = updateKeyValue(m.key,
+										  m.value,
+										  m.replica,
+										  m.expiry);
+
+			if (success)
+			{
+				logSuccess(UPDATE,
+						   false,
+						   m.transID,
+						   m.key,
+						   m.value);
+			}
+			else
+			{
+				logFail(UPDATE,
+						false,
+						m.transID,
+						m.key,
+						m.value);
+			}
+
+			Message reply(m.transID, this->memberNode->addr, REPLY, success); 
+
+			// Version of the write
+			reply.timestamp = par->getcurrtime();
+
+			string data(reply.toString());
+
+			int size = emulNet->ENsend(&memberNode->addr,
+									   &m.fromAddr,
+									   (char *)data.c_str(),
+									   (int)data.length());
+
+			break;
+
+		}
+
+		case HINT:
+		{
+			if (m.hintFor == memberNode->addr)
+			{
+				applyHint(m);
+			}
+			else
+			{
+				storeHint(m);
+			}
+
+			break;
+		}
+
+		case HINTACK:
+		{
+			hints.erase(make_pair(*(int *)(&m.fromAddr.addr), m.key));
+			if (!handoffs.empty())
+			{
+				confirmHandoff(*(int *)(&m.fromAddr.addr), m.key);
+			}
+
+			break;
+		}
+
+		case TREE:
+		{
+			recvTree(m);
+
+			break;
+		}
+
+		case TREEKEYS:
+		{
+			recvTreeKeys(m);
+
+			break;
+		}
+
+		case BATCH:
+		{
+			serveBatch(m);
+
+			break;
+		}
+
+		case BATCHREPLY:
+		{
+			recvBatchReply(m);
+
+			break;
+		}
+
+		case SCAN:
+		{
+			serveScan(m);
+
+			break;
+		}
+
+		case SCANREPLY:
+		{
+			recvScanReply(m);
+
+			break;
+		}
+
+		case LOAD:
+		{
+			serveLoad(m);
+
+			break;
+		}
+
+		case LOADACK:
+		{
+			recvLoadAck(m);
+
+			break;
+		}
+
+		case DELETE:
+		{
+			bool success = deletekey(m.key);
+
+			if (success)
+			{
+				logSuccess(DELETE,
+						   false,
+						   m.transID,
+						   m.key,
+						   "");
+			}
+			else
+			{
+				logFail(DELETE,
+						false,
+						m.transID,
+						m.key,
+						"");
+			}
+			
+			Message reply(m.transID, this->memberNode->addr, REPLY, success); 
+
+			// Version of the write
+			reply.timestamp = par->getcurrtime();
+
+			string data(reply.toString());
+
+			int size = emulNet->ENsend(&memberNode->addr,
+									   &m.fromAddr,
+									   (char *)data.c_str(),
+									   (int)data.length());
+
+			break;
+		}
+      
+	    case READREPLY:
+		{
+			transInfo *trans = acks.find(m.transID);
+
+			if (trans)
+			{
+				int index = recordAnswer(trans, &m.fromAddr);
+				int version = m.value != "" ? m.timestamp : -1;
+
+				// Only a value from a replica asked for it counts
+				if (index < 0 || !(trans->valueAsked & (1u << index)))
+				{
+					break;
+				}
+				trans->versions[index] = version;
+				trans->digests[index] = valueDigest(m.value);
+				trans->fetching &= ~(1u << index);
+				trans->counted |= 1u << index;
+				trans->haveFull = true;
+				// The newest version wins
+				if (version > trans->newestVersion)
+				{
+					trans->newestVersion = version;
+					trans->newest = m.value;
+					trans->expiry = m.expiry;
+				}
+			}
+
+			if (trans && !trans->decided)
+			{
+				if (m.value != "")
+				{
+					trans->numSucc++;
+				}
+				else
+				{
+					trans->numFail++;
+				}
+
+				if (trans->fullIndex != -1)
+				{
+					checkDigests(trans);
+				}
+				if (trans->numFail > 0 && trans->hedgeTimer)
+				{
+					// The replicas sent to can no longer make the level alone
+					hedgeRead(trans);
+				}
+				decideTransaction(trans, trans->newest);
+			}
+			else if (trans &&
+					 trans->answered == trans->sent)
+			{
+				// Every replica answered a decided read
+				readRepair(trans);
+				timeouts.cancel(trans->timer);
+				acks.close(trans);
+			}
+			
+            break;
+		}
+
+		case REPLY:
+		{
+			transInfo *trans = acks.find(m.transID);
+
+			if (trans)
+			{
+				recordAnswer(trans, &m.fromAddr);
+			}
+
+			if (trans && !trans->decided)
+			{
+				if (m.success)
+				{
+					trans->numSucc++;
+					trans->newestVersion = max(trans->newestVersion, m.timestamp);
+				}
+				else
+				{
+					trans->numFail++;
+				}
+
+				decideTransaction(trans, trans->value);
+			}
+			else 
+			{
+				//ignore
+				// quorum/decision may have already been reached
+			}
+
+		    break;	
+		}
+		}
+	}
+
+	if (!lateValues.empty())
+	{
+		fetchLateValues();
+	}
+
+	/*
+	 * This function should also ensure all READ and UPDATE operation
+	 * get the replies of their consistency level.
+	 * Only the transactions whose deadline passed are visited.
+	 */
+	vector<long> expired;
+	timeouts.advance(par->getcurrtime(), expired);
+
+	for (auto transID : expired)
+	{
+		if (transID < 0)
+		{
+			// Hedge timer of a read; a closed one finds nothing
+			transInfo *trans = acks.find(-transID);
+
+			if (trans && !trans->decided)
+			{
+				hedgeRead(trans);
+			}
+			continue;
+		}
+
+		transInfo *trans = acks.find(transID);
+
+		if (trans && (trans->held > 0 || trans->lastSent + TRANS_TIMEOUT > par->getcurrtime()))
+		{
+			// Requests held in a replica window get their own TRANS_TIMEOUT
+			// from when they go out
+			trans->timer = timeouts.schedule(trans->held > 0 ? par->getcurrtime() + 1 : trans->lastSent + TRANS_TIMEOUT,
+											 transID);
+			continue;
+		}
+
+		if (trans)
+		{
+			if (par->HEDGED_READS)
+			{
+				// A node that never answered counts as answering after SUSPECT_TIME
+				for (int index = 0; index < trans->asked.count; ++index)
+				{
+					if ((trans->sent & ~trans->answered) & (1u << index))
+					{
+						recordLatency(&trans->asked.nodes[index], SUSPECT_TIME, false);
+					}
+				}
+			}
+
+			if (!trans->batch.empty())
+			{
+				for (auto &batchKey : trans->batch)
+				{
+					if (!batchKey.decided)
+					{
+						logFail(trans->type, true, trans->id, batchKey.key, batchKey.value);
+						completeOp(batchKey.handle, false, "", -1);
+					}
+				}
+			}
+			else if (!trans->decided)
+			{
+				logFail(trans->type,
+						true,
+						trans->id,
+						trans->key,
+						trans->value);
+				completeOp(trans->handle, false, "", -1);
+			}
+
+			suspectSilent(trans);
+			readRepair(trans);
+			acks.close(trans);
+		}
+	}
+
+	if (!windows.empty())
+	{
+		flushWindows();
+	}
+
+	if (!hints.empty())
+	{
+		replayHints();
+	}
+
+	if (expiring && par->TTL_SWEEP > 0)
+	{
+		sweepExpired();
+	}
+
+	// Stagger the exchanges of different nodes over the period
+	if (par->ANTI_ENTROPY_PERIOD > 0 &&
+		(par->getcurrtime() + *(int *)(&memberNode->addr.addr)) % par->ANTI_ENTROPY_PERIOD == 0)
+	{
+		antiEntropy();
+	}
+
+	// Resume the clients waiting on operations decided this tick; what they
+	// start in turn waits for the ticks to come
+	if (!resumptions.empty())
+	{
+		vector<function<void()> > ready;
+
+		ready.swap(resumptions);
+		for (size_t i = 0; i < ready.size(); ++i)
+		{
+			ready[i]();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: findNodes
+ *
+ * DESCRIPTION: Find the replicas of the given keyfunction
+ * 				This function is responsible for finding the replicas of a key
+ */
+vector<Node> MP2Node::findNodes(string key)
+{
+	ReplicaSet replicas;
+	vector<Node> addr_vec;
+
+	firstReplicas(replicaTable.lookup(hashFunction(key)), replicationFactor(key), replicas);
+
+	for (int index = 0; index < replicas.count; ++index)
+	{
+		addr_vec.emplace_back(Node(replicas.nodes[index]));
+	}
+	return addr_vec;
+}
+
+/**
+ * FUNCTION NAME: recvLoop
+ *
+ * DESCRIPTION: Receive messages from EmulNet and push into the queue (mp2q)
+ */
+bool MP2Node::recvLoop()
+{
+	if (memberNode->bFailed)
+	{
+		return false;
+	}
+	else
+	{
+		return emulNet->ENrecv(&(memberNode->addr), this->enqueueWrapper, NULL, 1, &(memberNode->mp2q));
+	}
+}
+
+/**
+ * FUNCTION NAME: enqueueWrapper
+ *
+ * DESCRIPTION: Enqueue the message from Emulnet into the queue of MP2Node
+ */
+int MP2Node::enqueueWrapper(void *env, char *buff, int size)
+{
+	Queue q;
+	return q.enqueue((queue<q_elt> *)env, (void *)buff, size);
+}
+/**
+ * FUNCTION NAME: diffRings
+ *
+ * DESCRIPTION: Diff two rings. Between two consecutive tokens of either ring the
+ * 				replica set is the same for every position, so each such range
+ * 				is looked up once in both rings.
+ *
+ * RETURNS:
+ * the number of ranges whose replicas changed
+ */
+int MP2Node::diffRings(ReplicaTable &oldTable, ReplicaTable &newTable, map<uint64_t, RangeChange> &ranges)
+{
+	int changed = 0;
+
+	for (size_t i = 0; i < oldTable.size(); i++)
+	{
+		ranges[oldTable.token(i)];
+	}
+	for (size_t i = 0; i < newTable.size(); i++)
+	{
+		ranges[newTable.token(i)];
+	}
+
+	for (auto &range : ranges)
+	{
+		range.second.oldReplicas = oldTable.lookup(range.first);
+		range.second.newReplicas = newTable.lookup(range.first);
+		range.second.changed = !sameReplicas(range.second.oldReplicas, range.second.newReplicas);
+		changed += range.second.changed ? 1 : 0;
+	}
+
+	return changed;
+}
+
+/**
+ * FUNCTION NAME: stabilizationProtocol
+ *
+ * DESCRIPTION: This runs the stabilization protocol in case of Node joins and leaves
+ * 				It ensures that there always 3 copies of all keys in the DHT at all times
+ * 				The function does the following:
+ *				1) Ensures that there are three "CORRECT" replicas of all the keys in spite of failures and joins
+ *				Note:- "CORRECT" replicas implies that every key is replicated in its two neighboring nodes in the ring
+ *
+ *				Only the keys in token ranges whose replica set changed between oldTable
+ *				and the current ring are looked at. Each holder hands such a key to the
+ *				replicas that newly own it as a hint, replayed until they confirm it.
+ *				A holder that no longer owns the key drops it once they all have.
+ *				A stable ring sends nothing.
+ */
+void MP2Node::stabilizationProtocol(ReplicaTable &oldTable)
+{
+	/*
+	 * Implement this
+	 */
+	map<uint64_t, RangeChange> ranges;
+
+	if (ht->currentSize() == 0 || diffRings(oldTable, replicaTable, ranges) == 0)
+	{
+		return;
+	}
+
+	vector<string> dropped;
+
+	for (auto &kv : ht->hashTable)
+	{
+		// Ranges are keyed by their upper token; past the last one wraps to the first
+		auto range = ranges.lower_bound(hashFunction(kv.first));
+
+		if (range == ranges.end())
+		{
+			range = ranges.begin();
+		}
+		if (!range->second.changed)
+		{
+			continue;
+		}
+
+		// Only the first replication factor nodes of the range hold the key
+		int replicas = replicationFactor(kv.first);
+		ReplicaSet oldReplicas, newReplicas;
+		firstReplicas(range->second.oldReplicas, replicas, oldReplicas);
+		firstReplicas(range->second.newReplicas, replicas, newReplicas);
+
+		// A ring too small for the key keeps it where it is
+		if (newReplicas.count == 0 || sameReplicas(oldReplicas, newReplicas))
+		{
+			continue;
+		}
+
+		Entry e(kv.second);
+		bool mine = false;
+
+		for (int index = 0; index < newReplicas.count; ++index)
+		{
+			Address &replica = newReplicas.nodes[index];
+
+			if (replica == memberNode->addr)
+			{
+				// Still a replica, possibly at another position
+				mine = true;
+				e.replica = GetReplicaType(index);
+				kv.second = e.convertToString();
+				continue;
+			}
+
+			// An expired key is not worth moving
+			if (isReplica(oldReplicas, &replica) || e.expiredAt(par->getcurrtime()))
+			{
+				continue;
+			}
+
+			// Handed over as a hint at the version held, sent by replayHints
+			// this tick and again until the replica confirms it
+			int id = *(int *)(&replica.addr);
+			bool held = hints.count(make_pair(id, kv.first)) > 0;
+			Hint &hint = hints[make_pair(id, kv.first)];
+
+			// A newer write held for the replica already is kept
+			if (!held || hint.timestamp < e.timestamp)
+			{
+				hint.owner = replica;
+				hint.type = CREATE;
+				hint.value = e.value;
+				hint.replica = GetReplicaType(index);
+				hint.timestamp = e.timestamp;
+				hint.expiry = e.expiry;
+			}
+			hint.nextTry = par->getcurrtime();
+			handoffs[kv.first].insert(id);
+		}
+
+		if (mine)
+		{
+			handoffs.erase(kv.first);
+		}
+		else if (handoffs.find(kv.first) == handoffs.end())
+		{
+			dropped.push_back(kv.first);
+		}
+	}
+
+	for (auto &key : dropped)
+	{
+		ht->deleteKey(key);
+	}
+}
+
+/**
+ * FUNCTION NAME: handoffKeys
+ *
+ * DESCRIPTION: Called right before this node leaves the group. Every key it holds
+ * 				is re-created on the replicas it will have once this node is off the
+ * 				ring, so the other nodes never see a key range short of a replica.
+ */
+void MP2Node::handoffKeys()
+{
+	vector<Node> remaining;
+
+	for (auto node : ring)
+	{
+		if (!(*node.getAddress() == memberNode->addr))
+		{
+			remaining.push_back(node);
+		}
+	}
+
+	ReplicaTable oldTable(replicaTable);
+	ring = remaining;
+	replicaTable.build(ring, maxReplicas);
+	stabilizationProtocol(oldTable);
+	// This node does not tick again, its keys go out now and only once
+	replayHints();
+}
+
+
+/**
+ * FUNCTION NAME: storeHint
+ *
+ * DESCRIPTION: Hold a write meant for an unavailable replica and count it toward
+ * 				the quorum of the coordinator. The hint is not served to readers.
+ */
+void MP2Node::storeHint(Message &m)
+{
+	Hint &hint = hints[make_pair(*(int *)(&m.hintFor.addr), m.key)];
+
+	// A later write of the key replaces the one held before
+	hint.owner = m.hintFor;
+	hint.type = m.hintType;
+	hint.value = m.value;
+	hint.replica = m.replica;
+	hint.timestamp = m.timestamp;
+	hint.expiry = m.expiry;
+	hint.nextTry = par->getcurrtime() + par->HINT_RETRY;
+
+	Message reply(m.transID, this->memberNode->addr, REPLY, true);
+
+	// The replica gets the write at the version of the coordinator
+	reply.timestamp = m.timestamp;
+
+	string data(reply.toString());
+
+	emulNet->ENsend(&memberNode->addr,
+					&m.fromAddr,
+					(char *)data.c_str(),
+					(int)data.length());
+}
+
+/**
+ * FUNCTION NAME: applyHint
+ *
+ * DESCRIPTION: Apply a write that another node held for this one while it did not
+ * 				answer, a read repair or a key handed over by stabilization, and
+ * 				confirm it. The write keeps its version and is skipped if this
+ * 				node holds a newer version. It is neither applied nor confirmed
+ * 				while this node does not replicate the key, so a sender whose
+ * 				ring is ahead of this one tries again later.
+ */
+void MP2Node::applyHint(Message &m)
+{
+	ReplicaSet replicas;
+	firstReplicas(replicaTable.lookup(hashFunction(m.key)), replicationFactor(m.key), replicas);
+
+	if (!isReplica(replicas, &memberNode->addr))
+	{
+		return;
+	}
+	applyVersion(m.key, m.value, m.timestamp, m.hintType == DELETE, m.replica, m.expiry);
+
+	Message ack(0, memberNode->addr, HINTACK, m.key);
+
+	string data(ack.toString());
+
+	emulNet->ENsend(&memberNode->addr,
+					&m.fromAddr,
+					(char *)data.c_str(),
+					(int)data.length());
+}
+
+/**
+ * FUNCTION NAME: replayHints
+ *
+ * DESCRIPTION: Every HINT_RETRY ticks send each held write to its replica until it
+ * 				confirms. Hints of nodes that no longer replicate the key, or
+ * 				left the ring, are dropped; the stabilization protocol has
+ * 				handed the key to its replicas since.
+ */
+void MP2Node::replayHints()
+{
+	int currenttime = par->getcurrtime();
+
+	for (auto it = hints.begin(); it != hints.end(); )
+	{
+		Hint &hint = it->second;
+		ReplicaSet replicas;
+
+		firstReplicas(replicaTable.lookup(hashFunction(it->first.second)), replicationFactor(it->first.second), replicas);
+		if (!isReplica(replicas, &hint.owner))
+		{
+			int id = it->first.first;
+			string key = it->first.second;
+
+			it = hints.erase(it);
+			if (!handoffs.empty())
+			{
+				confirmHandoff(id, key);
+			}
+			continue;
+		}
+
+		if (hint.nextTry <= currenttime)
+		{
+			// transID 0: replays are not logged
+			Message m(0, memberNode->addr, it->first.second, hint.value, hint.replica, hint.owner, hint.type, hint.timestamp);
+
+			m.expiry = hint.expiry;
+
+			string data(m.toString());
+
+			emulNet->ENsend(&memberNode->addr,
+							&hint.owner,
+							(char *)data.c_str(),
+							(int)data.length());
+
+			hint.nextTry = currenttime + par->HINT_RETRY;
+		}
+		++it;
+	}
+}
+
+/**
+ * FUNCTION NAME: confirmHandoff
+ *
+ * DESCRIPTION: Strike the given node off the replicas a key is handed to, and
+ * 				drop the key once none is left and this node no longer
+ * 				replicates it
+ */
+void MP2Node::confirmHandoff(int id, const string &key)
+{
+	auto handoff = handoffs.find(key);
+
+	if (handoff == handoffs.end())
+	{
+		return;
+	}
+	handoff->second.erase(id);
+	if (!handoff->second.empty())
+	{
+		return;
+	}
+	handoffs.erase(handoff);
+
+	ReplicaSet replicas;
+	firstReplicas(replicaTable.lookup(hashFunction(key)), replicationFactor(key), replicas);
+
+	if (!isReplica(replicas, &memberNode->addr))
+	{
+		ht->deleteKey(key);
+	}
+}
+
+/**
+ * FUNCTION NAME: applyVersion
+ *
+ * DESCRIPTION: Store the given version of key, a delete if deleted is set, unless
+ * 				the local one is at least as new. Versions are ordered by time,
+ * 				then deletes after writes, then by value, so every replica picks
+ * 				the same winner. A version whose time to live ran out counts as
+ * 				a delete, as does the local one.
+ *
+ * RETURNS:
+ * true if the local copy changed
+ */
+bool MP2Node::applyVersion(const string &key, const string &value, int version, bool deleted, ReplicaType replica, int expiry)
+{
+	if (!deleted && expiry != 0 && expiry <= par->getcurrtime())
+	{
+		deleted = true;
+	}
+	expireKey(key);
+
+	int localVersion = -1;
+	bool localDeleted = false;
+	string localValue = readKey(key, localVersion);
+
+	if (localValue == "")
+	{
+		auto tombstone = tombstones.find(key);
+
+		localVersion = tombstone != tombstones.end() ? tombstone->second : -1;
+		localDeleted = tombstone != tombstones.end();
+	}
+
+	bool newer = version != localVersion ? version > localVersion :
+				 deleted != localDeleted ? deleted : value > localValue;
+
+	if (!newer)
+	{
+		return false;
+	}
+
+	uint64_t before = itemHash(key);
+
+	if (deleted)
+	{
+		ht->deleteKey(key);
+		if (par->ANTI_ENTROPY_PERIOD > 0)
+		{
+			tombstones[key] = version;
+		}
+	}
+	else
+	{
+		Entry e(value, version, replica, expiry);
+
+		if (!ht->update(key, e.convertToString()))
+		{
+			ht->create(key, e.convertToString());
+		}
+		tombstones.erase(key);
+		if (expiry != 0)
+		{
+			expiring = true;
+		}
+	}
+
+	merkleUpdate(key, before);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: versionHash
+ *
+ * DESCRIPTION: Hash of one version of a key, the item a Merkle leaf is made of.
+ * 				The replica type differs between replicas and is left out.
+ *
+ * RETURNS:
+ * a non zero hash
+ */
+uint64_t MP2Node::versionHash(const string &key, const string &value, int version, bool deleted)
+{
+	string item = key + '\0' + value + '\0' + to_string(version) + (deleted ? "\1" : "");
+
+	return ringHash(item) | 1;
+}
+
+/**
+ * FUNCTION NAME: itemHash
+ *
+ * DESCRIPTION: Hash of the local version of key, expired or not; an expired key
+ * 				stays in its tree until it is reclaimed
+ *
+ * RETURNS:
+ * 0 if there is none or anti-entropy is off
+ */
+uint64_t MP2Node::itemHash(const string &key)
+{
+	if (par->ANTI_ENTROPY_PERIOD <= 0)
+	{
+		return 0;
+	}
+
+	string entryStr = ht->read(key);
+
+	if (entryStr != "")
+	{
+		Entry e(entryStr);
+
+		return versionHash(key, e.value, e.timestamp, false);
+	}
+
+	auto tombstone = tombstones.find(key);
+
+	if (tombstone != tombstones.end())
+	{
+		return versionHash(key, "", tombstone->second, true);
+	}
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: treeOf
+ *
+ * DESCRIPTION: Returns the Merkle tree key belongs to, NULL if this node does not replicate it
+ */
+MerkleTree *MP2Node::treeOf(const string &key, uint64_t keyHash)
+{
+	if (replicaTable.size() == 0)
+	{
+		return NULL;
+	}
 
-			Message readReply(m.transID, this->memberNode->addr, value); 
+	uint64_t token = replicaTable.token(replicaTable.rangeOf(keyHash));
+	auto tree = trees.find(make_pair(token, replicationFactor(key)));
 
-			string data(readReply.toString());
+	return tree != trees.end() ? &tree->second : NULL;
+}
 
-			int size = emulNet->ENsend(&memberNode->addr,
-									   &m.fromAddr,
-									   (char *)data.c_str(),
-									   (int)data.length());
+/**
+ * FUNCTION NAME: merkleUpdate
+ *
+ * DESCRIPTION: Fold a change of key into its tree; before is the item hash of key
+ * 				before the change
+ */
+void MP2Node::merkleUpdate(const string &key, uint64_t before)
+{
+	if (par->ANTI_ENTROPY_PERIOD <= 0)
+	{
+		return;
+	}
 
-			break;
-		}
+	uint64_t after = itemHash(key);
 
-		case UPDATE:
-		{
-			bool success = updateKeyValue(m.key,
-										  m.value,
-										  m.replica);
+	if (before == after)
+	{
+		return;
+	}
 
-			if (success)
-			{
-				logSuccess(UPDATE,
-						   false,
-						   m.transID,
-						   m.key,
-						   m.value);
-			}
-			else
-			{
-				logFail(UPDATE,
-						false,
-						m.transID,
-						m.key,
-						m.value);
-			}
+	uint64_t keyHash = hashFunction(key);
+	MerkleTree *tree = treeOf(key, keyHash);
 
-			Message reply(m.transID, this->memberNode->addr, REPLY, success); 
+	if (tree)
+	{
+		tree->update(key, keyHash, before, after);
+	}
+}
 
-			string data(reply.toString());
+/**
+ * FUNCTION NAME: rebuildTrees
+ *
+ * DESCRIPTION: Called after a ring change. Make an empty tree for every token range
+ * 				and replication factor this node is a replica of, then add every
+ * 				key and tombstone it holds.
+ */
+void MP2Node::rebuildTrees()
+{
+	if (par->ANTI_ENTROPY_PERIOD <= 0)
+	{
+		return;
+	}
 
-			int size = emulNet->ENsend(&memberNode->addr,
-									   &m.fromAddr,
-									   (char *)data.c_str(),
-									   (int)data.length());
+	vector<int> factors(1, min(par->REPLICATION_FACTOR, MAX_REPLICAS));
 
-			break;
+	for (auto &keyspace : par->KEYSPACES)
+	{
+		factors.push_back(min(keyspace.second, MAX_REPLICAS));
+	}
+	sort(factors.begin(), factors.end());
+	factors.erase(unique(factors.begin(), factors.end()), factors.end());
 
-		}
+	trees.clear();
+	for (size_t i = 0; i < replicaTable.size(); i++)
+	{
+		const ReplicaSet &replicas = replicaTable.lookup(replicaTable.token(i));
 
-		case DELETE:
+		for (int position = 0; position < replicas.count; ++position)
 		{
-			bool success = deletekey(m.key);
-
-			if (success)
+			if (!(memberNode->addr == replicas.nodes[position]))
 			{
-				logSuccess(DELETE,
-						   false,
-						   m.transID,
-						   m.key,
-						   "");
+				continue;
 			}
-			else
+			for (int factor : factors)
 			{
-				logFail(DELETE,
-						false,
-						m.transID,
-						m.key,
-						"");
+				if (position < factor && factor <= replicas.count)
+				{
+					trees[make_pair(replicaTable.token(i), factor)];
+				}
 			}
-			
-			Message reply(m.transID, this->memberNode->addr, REPLY, success); 
+		}
+	}
 
-			string data(reply.toString());
+	for (auto &kv : ht->hashTable)
+	{
+		merkleUpdate(kv.first, 0);
+	}
+	for (auto &tombstone : tombstones)
+	{
+		merkleUpdate(tombstone.first, 0);
+	}
+}
 
-			int size = emulNet->ENsend(&memberNode->addr,
-									   &m.fromAddr,
-									   (char *)data.c_str(),
-									   (int)data.length());
+/**
+ * FUNCTION NAME: treePeer
+ *
+ * DESCRIPTION: Find the replica after this node among the first replicas nodes of
+ * 				the range ending at token, wrapping around to the first one
+ *
+ * RETURNS:
+ * true if there is another replica
+ */
+bool MP2Node::treePeer(uint64_t token, int replicas, Address &peer)
+{
+	const ReplicaSet &nodes = replicaTable.lookup(token);
+	int count = min(replicas, nodes.count);
 
-			break;
-		}
-      
-	    case READREPLY:
+	for (int position = 0; position < count; ++position)
+	{
+		if (memberNode->addr == nodes.nodes[position] && count > 1)
 		{
-			auto it = acks.find(m.transID);
+			peer = nodes.nodes[(position + 1) % count];
+			return true;
+		}
+	}
+	return false;
+}
 
-			if (it != acks.end()) 
-			{
-				if (m.value != "")
-				{
-					it->second.numSucc++;
-				}
-				else
-				{
-					it->second.numFail++;
-				}
+/**
+ * FUNCTION NAME: sendTreeKeys
+ *
+ * DESCRIPTION: Send every local version, deletes included, under the given leaves.
+ * 				With reply set the peer answers with its own versions of the leaves.
+ * 				The versions go in as many TREEKEYS frames as MAX_MSG_SIZE needs;
+ * 				a frame names the leaves that start in it, so each is answered once.
+ */
+void MP2Node::sendTreeKeys(Address *to, MerkleTree &tree, const string &token, const string &replicas, bool reply, vector<int> &leaves)
+{
+	size_t limit = (size_t)max(par->MAX_MSG_SIZE - LOAD_FRAME_SLACK, 1);
+	vector<int> frameLeaves;
+	vector<string> items;
+	size_t bytes = 0;
 
-				if (it->second.numSucc == (NUM_REPLICAS / 2 + 1))
-				{
-					logSuccess(it->second.type,
-					           true,
-							   m.transID,
-							   it->second.key,
-							   m.value);
+	for (int leaf : leaves)
+	{
+		string leafId = to_string(leaf);
 
-					acks.erase(it);
-				}
-				else if (it->second.numFail == (NUM_REPLICAS / 2))
-				{
-					logFail(it->second.type,
-					        true,
-							m.transID,
-							it->second.key,
-							m.value);
+		if (bytes + leafId.size() + 2 > limit)
+		{
+			sendTreeFrame(to, token, replicas, reply, frameLeaves, items);
+			bytes = 0;
+		}
+		frameLeaves.push_back(leaf);
+		bytes += leafId.size() + 2;
 
-					acks.erase(it);
-				}
-			}
-			else 
+		for (auto &key : tree.leafKeys(leaf))
+		{
+			string entryStr = ht->read(key);
+			bool deleted = entryStr == "";
+			// The version the leaf hashed, expired or not
+			Entry e = deleted ? Entry("", tombstones[key], PRIMARY) : Entry(entryStr);
+			string version = to_string(e.timestamp);
+			string expiry = to_string(e.expiry);
+			// the five fields and their delimiters
+			size_t size = key.size() + e.value.size() + version.size() + expiry.size() + 11;
+
+			if (bytes + size > limit && (!items.empty() || frameLeaves.size() > 1))
 			{
-				//ignore
-				// quorum/decision may have already been reached
+				sendTreeFrame(to, token, replicas, reply, frameLeaves, items);
+				bytes = 0;
 			}
-			
-            break;
+			items.push_back(key);
+			items.push_back(e.value);
+			items.push_back(version);
+			items.push_back(deleted ? "1" : "0");
+			items.push_back(expiry);
+			bytes += size;
 		}
+	}
 
-		case REPLY:
-		{
-			auto it = acks.find(m.transID);
-
-			if (it != acks.end()) 
-			{
-				if (m.success)
-				{
-					it->second.numSucc++;
-				}
-				else
-				{
-					it->second.numFail++;
-				}
+	if (!frameLeaves.empty() || !items.empty())
+	{
+		sendTreeFrame(to, token, replicas, reply, frameLeaves, items);
+	}
+}
 
-				if (it->second.numSucc == (NUM_REPLICAS / 2 + 1))
-				{
-					logSuccess(it->second.type,
-					           true,
-							   m.transID,
-							   it->second.key,
-							   it->second.value);
+/**
+ * FUNCTION NAME: sendTreeFrame
+ *
+ * DESCRIPTION: Send one TREEKEYS frame of the given leaves and versions, and empty them
+ */
+void MP2Node::sendTreeFrame(Address *to, const string &token, const string &replicas, bool reply, vector<int> &leaves, vector<string> &items)
+{
+	vector<string> fields;
 
-					acks.erase(it);
-				}
-				else if (it->second.numFail == (NUM_REPLICAS / 2))
-				{
-					logFail(it->second.type,
-					        true,
-							m.transID,
-							it->second.key,
-							it->second.value);
+	fields.push_back(token);
+	fields.push_back(replicas);
+	fields.push_back(reply ? "1" : "0");
+	fields.push_back(to_string(leaves.size()));
+	for (int leaf : leaves)
+	{
+		fields.push_back(to_string(leaf));
+	}
+	fields.insert(fields.end(), items.begin(), items.end());
+	leaves.clear();
+	items.clear();
 
-					acks.erase(it);
-				}
-			}
-			else 
-			{
-				//ignore
-				// quorum/decision may have already been reached
-			}
+	// transID 0: anti-entropy traffic is not logged
+	Message m(0, memberNode->addr, TREEKEYS, fields);
 
-		    break;	
-		}
-		}
-	}
+	string data(m.toString());
 
-	/*
-	 * This function should also ensure all READ and UPDATE operation
-	 * get QUORUM replies
-	 */
-	int currtime = par->getcurrtime();
-	using mapIter = map<int, transInfo>::iterator; 
+	emulNet->ENsend(&memberNode->addr,
+					to,
+					(char *)data.c_str(),
+					(int)data.length());
+}
 
-    mapIter it = acks.begin();
+/**
+ * FUNCTION NAME: antiEntropy
+ *
+ * DESCRIPTION: Forget expired tombstones, then send the root of every tree to the
+ * 				next replica of its range. Replicas that agree stop there; the
+ * 				others descend into the differing subtrees only.
+ */
+void MP2Node::antiEntropy()
+{
+	int currenttime = par->getcurrtime();
 
-	while (it != acks.end())
+	for (auto it = tombstones.begin(); it != tombstones.end(); )
 	{
-		if (currtime - it->second.timestamp >= 2)
+		if (currenttime - it->second > par->TOMBSTONE_TIME)
 		{
-			logFail(it->second.type,
-					true,
-					it->first,
-					it->second.key,
-					it->second.value);
+			string key = it->first;
+			uint64_t before = itemHash(key);
 
-			it = acks.erase(it);
+			it = tombstones.erase(it);
+			merkleUpdate(key, before);
 		}
 		else
 		{
 			++it;
 		}
 	}
+
+	for (auto &tree : trees)
+	{
+		Address peer;
+
+		if (!treePeer(tree.first.first, tree.first.second, peer))
+		{
+			continue;
+		}
+
+		vector<string> fields;
+
+		fields.push_back(to_string(tree.first.first));
+		fields.push_back(to_string(tree.first.second));
+		fields.push_back("1");
+		fields.push_back(to_string(tree.second.hash(1)));
+
+		Message m(0, memberNode->addr, TREE, fields);
+
+		string data(m.toString());
+
+		emulNet->ENsend(&memberNode->addr,
+						&peer,
+						(char *)data.c_str(),
+						(int)data.length());
+	}
 }
 
 /**
- * FUNCTION NAME: findNodes
+ * FUNCTION NAME: recvTree
  *
- * DESCRIPTION: Find the replicas of the given keyfunction
- * 				This function is responsible for finding the replicas of a key
+ * DESCRIPTION: Compare the node hashes a peer sent with the local tree. Answer with
+ * 				the children of differing inner nodes, in TREE frames kept
+ * 				under MAX_MSG_SIZE, and with the keys of differing leaves.
  */
-vector<Node> MP2Node::findNodes(string key)
+void MP2Node::recvTree(Message &m)
 {
-	size_t pos = hashFunction(key);
-	vector<Node> addr_vec;
-	if (ring.size() >= 3)
+	if (m.fields.size() < 2)
+	{
+		return;
+	}
+
+	auto it = trees.find(make_pair(stoull(m.fields[0]), stoi(m.fields[1])));
+
+	if (it == trees.end())
+	{
+		return;
+	}
+
+	MerkleTree &tree = it->second;
+	vector<string> children(m.fields.begin(), m.fields.begin() + 2);
+	vector<int> leaves;
+	size_t limit = (size_t)max(par->MAX_MSG_SIZE - LOAD_FRAME_SLACK, 1);
+	size_t bytes = 0;
+
+	for (size_t i = 2; i + 1 < m.fields.size(); i += 2)
 	{
-		// if pos <= min || pos > max, the leader is the min
-		if (pos <= ring.at(0).getHashCode() || pos > ring.at(ring.size() - 1).getHashCode())
+		int index = stoi(m.fields[i]);
+
+		if (index < 1 || index >= 2 * MERKLE_LEAVES || tree.hash(index) == stoull(m.fields[i + 1]))
 		{
-			addr_vec.emplace_back(ring.at(0));
-			addr_vec.emplace_back(ring.at(1));
-			addr_vec.emplace_back(ring.at(2));
+			continue;
 		}
-		else
+
+		if (MerkleTree::isLeaf(index))
+		{
+			leaves.push_back(index);
+			continue;
+		}
+
+		for (int child = 2 * index; child <= 2 * index + 1; child++)
 		{
-			// go through the ring until pos <= node
-			for (int i = 1; i < ring.size(); i++)
+			string node = to_string(child);
+			string hash = to_string(tree.hash(child));
+
+			// the index and hash, and their delimiters
+			if (children.size() > 2 && bytes + node.size() + hash.size() + 4 > limit)
 			{
-				Node addr = ring.at(i);
-				if (pos <= addr.getHashCode())
-				{
-					addr_vec.emplace_back(addr);
-					addr_vec.emplace_back(ring.at((i + 1) % ring.size()));
-					addr_vec.emplace_back(ring.at((i + 2) % ring.size()));
-					break;
-				}
+				sendTreeNodes(&m.fromAddr, children);
+				bytes = 0;
 			}
+			children.push_back(node);
+			children.push_back(hash);
+			bytes += node.size() + hash.size() + 4;
 		}
 	}
-	return addr_vec;
-}
 
-/**
- * FUNCTION NAME: recvLoop
- *
- * DESCRIPTION: Receive messages from EmulNet and push into the queue (mp2q)
- */
-bool MP2Node::recvLoop()
-{
-	if (memberNode->bFailed)
+	if (children.size() > 2)
 	{
-		return false;
+		sendTreeNodes(&m.fromAddr, children);
 	}
-	else
+
+	if (!leaves.empty())
 	{
-		return emulNet->ENrecv(&(memberNode->addr), this->enqueueWrapper, NULL, 1, &(memberNode->mp2q));
+		sendTreeKeys(&m.fromAddr, tree, m.fields[0], m.fields[1], true, leaves);
 	}
 }
 
 /**
- * FUNCTION NAME: enqueueWrapper
+ * FUNCTION NAME: sendTreeNodes
  *
- * DESCRIPTION: Enqueue the message from Emulnet into the queue of MP2Node
+ * DESCRIPTION: Send a TREE frame of the node hashes in fields, after the token
+ * 				and replication factor of the range, and keep only those two
  */
-int MP2Node::enqueueWrapper(void *env, char *buff, int size)
+void MP2Node::sendTreeNodes(Address *to, vector<string> &fields)
 {
-	Queue q;
-	return q.enqueue((queue<q_elt> *)env, (void *)buff, size);
+	Message m(0, memberNode->addr, TREE, fields);
+
+	string data(m.toString());
+
+	emulNet->ENsend(&memberNode->addr,
+					to,
+					(char *)data.c_str(),
+					(int)data.length());
+	fields.resize(2);
 }
+
 /**
- * FUNCTION NAME: stabilizationProtocol
+ * FUNCTION NAME: recvTreeKeys
  *
- * DESCRIPTION: This runs the stabilization protocol in case of Node joins and leaves
- * 				It ensures that there always 3 copies of all keys in the DHT at all times
- * 				The function does the following:
- *				1) Ensures that there are three "CORRECT" replicas of all the keys in spite of failures and joins
- *				Note:- "CORRECT" replicas implies that every key is replicated in its two neighboring nodes in the ring
+ * DESCRIPTION: Answer with the local versions of the leaves if asked to, then keep
+ * 				the newer of each version the peer sent and the local one
  */
-void MP2Node::stabilizationProtocol()
+void MP2Node::recvTreeKeys(Message &m)
 {
-	/*
-	 * Implement this
-	 */
-	stabilizing = true;
-	
-	vector<pair<string, string>> 
-	allKVPairs(ht->hashTable.begin(), ht->hashTable.end());
+	if (m.fields.size() < 4)
+	{
+		return;
+	}
 
-	ht->hashTable.clear();
+	auto it = trees.find(make_pair(stoull(m.fields[0]), stoi(m.fields[1])));
 
-    for (auto kv: allKVPairs)
+	if (it == trees.end())
 	{
-		string key(kv.first);
+		return;
+	}
 
-		Entry e(kv.second);
+	MerkleTree &tree = it->second;
+	size_t count = stoul(m.fields[3]);
+	size_t first = 4 + count;
+
+	if (first > m.fields.size())
+	{
+		return;
+	}
+
+	if (m.fields[2] == "1")
+	{
+		vector<int> leaves;
 
-	    clientCreate(key, e.value);
+		for (size_t i = 4; i < first; i++)
+		{
+			leaves.push_back(stoi(m.fields[i]));
+		}
+		sendTreeKeys(&m.fromAddr, tree, m.fields[0], m.fields[1], false, leaves);
 	}
 
-	stabilizing = false;
+	for (size_t i = first; i + 4 < m.fields.size(); i += 5)
+	{
+		const string &key = m.fields[i];
+		uint64_t keyHash = hashFunction(key);
+		ReplicaSet replicas;
+
+		// Only keys of this very range and replication factor
+		if (treeOf(key, keyHash) != &tree)
+		{
+			continue;
+		}
+
+		firstReplicas(replicaTable.lookup(keyHash), replicationFactor(key), replicas);
+		for (int index = 0; index < replicas.count; ++index)
+		{
+			if (replicas.nodes[index] == memberNode->addr)
+			{
+				applyVersion(key, m.fields[i + 1], stoi(m.fields[i + 2]), m.fields[i + 3] == "1", GetReplicaType(index),
+							 stoi(m.fields[i + 4]));
+			}
+		}
+	}
 }
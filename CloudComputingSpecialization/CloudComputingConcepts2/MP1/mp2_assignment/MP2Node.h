@@ -18,18 +18,53 @@
 #include "Params.h"
 #include "Message.h"
 #include "Queue.h"
+#include "TimingWheel.h"
+#include "ReplicaTable.h"
+#include "MerkleTree.h"
+#include "PendingTable.h"
 
+// default replication factor, see REPLICATION_FACTOR and KEYSPACES
 #define NUM_REPLICAS 3
+// ticks a coordinator waits for quorum replies
+#define TRANS_TIMEOUT 2
+// ticks a replica that missed a reply is written around with HINTED_HANDOFF
+#define SUSPECT_TIME 10
+// weight of a new reply time in the average of its node, and reply times kept
+// for the hedge deadline (HEDGED_READS)
+#define LATENCY_WEIGHT 0.25
+#define LATENCY_SAMPLES 64
+// bytes of MAX_MSG_SIZE a LOAD, TREE, TREEKEYS or BATCH frame, or a SCANREPLY
+// page, leaves for its header and the network's
+#define LOAD_FRAME_SLACK 128
 
-typedef struct transInfo
+// A write held for a replica that did not answer, replayed until it does
+typedef struct Hint
 {
+	Address owner;
 	MessageType type;
-	string key;
 	string value;
+	ReplicaType replica;
 	int timestamp;
-	int numSucc;
-	int numFail;
-} transInfo;
+	int nextTry;
+	int expiry;
+} Hint;
+
+// Requests of open transactions on their way to one replica, and the requests
+// held back until fewer are (REPLICA_WINDOW)
+typedef struct ReplicaWindow
+{
+	Address addr;
+	multiset<TransID> inflight;
+	deque<pair<TransID, string> > queued;
+} ReplicaWindow;
+
+// Replicas of one token range before and after a ring change
+typedef struct RangeChange
+{
+	ReplicaSet oldReplicas;
+	ReplicaSet newReplicas;
+	bool changed;
+} RangeChange;
 
 /**
  * CLASS NAME: MP2Node
@@ -49,6 +84,32 @@ private:
 	vector<Node> haveReplicasOf;
 	// Ring
 	vector<Node> ring;
+	// Replica set of every token range of ring
+	ReplicaTable replicaTable;
+	// Largest replication factor of any keyspace, the width of replicaTable,
+	// and the smallest, the front replicas a scan reads from
+	int maxReplicas;
+	int minReplicas;
+	// Node id to the time until which writes go around it
+	map<int, int> suspects;
+	// Writes this node holds for other replicas, by replica id and key
+	map<pair<int, string>, Hint> hints;
+	// Keys the stabilization protocol hands over, to the ids of the replicas
+	// that did not confirm them yet; the key is kept until they all do
+	map<string, set<int> > handoffs;
+	// Request window of every replica this node coordinates requests to, by
+	// node id (REPLICA_WINDOW)
+	map<int, ReplicaWindow> windows;
+	// Merkle tree of the keys of every token range this node replicates, by
+	// range token and replication factor (ANTI_ENTROPY_PERIOD)
+	map<pair<uint64_t, int>, MerkleTree> trees;
+	// Deleted key to the version of its delete (ANTI_ENTROPY_PERIOD)
+	map<string, int> tombstones;
+	// Node id to its average reply time in ticks, and the latest reply
+	// times of all nodes, a ring of LATENCY_SAMPLES (HEDGED_READS)
+	map<int, double> latencies;
+	vector<int> latencySamples;
+	size_t nextSample;
 	// Hash Table
 	HashTable * ht;
 	// Member representing this member
@@ -60,29 +121,112 @@ private:
 	// Object of Log
 	Log * log;
 
-    map<int, transInfo> acks;
-	bool stabilizing = false; 
+	// transactions this node coordinates, by transaction id
+	PendingTable acks;
+	// timeout deadlines of the transactions in acks
+	TimingWheel timeouts;
+	// digest reads missing only their value, checked at the end of the tick
+	vector<TransID> lateValues;
+	// continuations of operations decided this tick, run at its end (KVTask)
+	vector<function<void()> > resumptions;
+	// whether a key with a time to live was stored, and the key the next
+	// sweep for expired keys starts at (TTL_SWEEP)
+	bool expiring;
+	string sweepFrom;
+
+	bool sameRing(vector<Node> &a, vector<Node> &b);
+	int diffRings(ReplicaTable &oldTable, ReplicaTable &newTable, map<uint64_t, RangeChange> &ranges);
 public:
 	MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *addressOfMember);
 	Member * getMemberNode() {
 		return this->memberNode;
 	}
 
-	void logSuccess(MessageType,bool,int,string,string);
-	void logFail(MessageType,bool,int,string,string);
+	void logSuccess(MessageType,bool,TransID,string,string);
+	void logFail(MessageType,bool,TransID,string,string);
 	ReplicaType GetReplicaType(int);
+	void closeTransaction(transInfo *trans);
+	TransID startTransaction(MessageType type, string key, string value, ConsistencyLevel level, ReplicaSet &replicas);
+	void decideTransaction(transInfo *trans, string value);
+	int recordAnswer(transInfo *trans, Address *from);
+	void readRepair(transInfo *trans);
+	static uint64_t valueDigest(const string &value);
+	void checkDigests(transInfo *trans);
+	void fetchValue(transInfo *trans, int index);
+	void fetchLateValues();
+	void suspectSilent(transInfo *trans);
+	void recordLatency(Address *from, int latency, bool sample);
+	int hedgeDelay();
+	void rankReplicas(ReplicaSet &replicas, int order[]);
+	void hedgeRead(transInfo *trans);
+	bool isSuspect(Address *addr);
+	bool findSubstitute(uint64_t keyHash, ReplicaSet &owners, ReplicaSet &taken, Address &substitute);
+	void sendWrite(TransID transID, MessageType type, string key, string value, ReplicaSet &replicas);
+	void sendRequest(TransID transID, Address &to, const string &data);
+	void releaseRequest(Address &from, TransID transID);
+	void flushWindow(ReplicaWindow &window);
+	void flushWindows();
 
 	// ring functionalities
 	void updateRing();
 	vector<Node> getMembershipList();
-	size_t hashFunction(string key);
+	static void addTokens(vector<Node> &ring, Address &address, Params *par);
+	static uint64_t hashFunction(const string &key);
 	void findNeighbors();
+	int replicationFactor(const string &key);
+	static int requiredReplies(ConsistencyLevel level, int replicas);
 
 	// client side CRUD APIs
-	void clientCreate(string key, string value);
-	void clientRead(string key);
-	void clientUpdate(string key, string value);
-	void clientDelete(string key);
+	// without a level, reads use READ_CONSISTENCY and writes WRITE_CONSISTENCY;
+	// a ttl above 0 makes a created or updated key expire that many ticks
+	// after the write; the handle returned completes when the operation is decided
+	OpHandle clientCreate(string key, string value);
+	OpHandle clientCreate(string key, string value, ConsistencyLevel level);
+	OpHandle clientCreate(string key, string value, ConsistencyLevel level, int ttl);
+	OpHandle clientRead(string key);
+	OpHandle clientRead(string key, ConsistencyLevel level);
+	OpHandle clientUpdate(string key, string value);
+	OpHandle clientUpdate(string key, string value, ConsistencyLevel level);
+	OpHandle clientUpdate(string key, string value, ConsistencyLevel level, int ttl);
+	OpHandle clientDelete(string key);
+	OpHandle clientDelete(string key, ConsistencyLevel level);
+	OpHandle newHandle(TransID transID, MessageType type, const string &key);
+	OpHandle handleOf(TransID transID, MessageType type, const string &key);
+	void completeOp(OpHandle &handle, bool success, const string &value, int version);
+	void defer(function<void()> resume);
+
+	// range scan over the keys from start up to end, "" for no end, at most
+	// limit of them, paged through one replica of each token range in key
+	// order; needs ORDERED_PARTITIONER, the rows end up in the handle
+	OpHandle clientScan(string start, string end, int limit);
+	void scanPage(transInfo *trans);
+	uint64_t scanRun(transInfo *trans, Address &replica);
+	void serveScan(Message &m);
+	void recvScanReply(Message &m);
+
+	// bulk load of a stream of pairs sorted by key: split by replica here and
+	// shipped in LOAD frames as large as the network takes, straight to the
+	// replicas, which append the keys as they come; no per-key transaction
+	// or log, the handle completes once every frame is acknowledged
+	OpHandle bulkLoad(const vector<pair<string, string> > &pairs);
+	void shipFrame(transInfo *trans, Address &to, vector<string> &fields);
+	void serveLoad(Message &m);
+	void recvLoadAck(Message &m);
+
+	// batched client APIs: one transaction and one message per replica node,
+	// each key decided at the level on its own; multiPut creates the keys
+	vector<OpHandle> multiPut(const map<string, string> &pairs);
+	vector<OpHandle> multiPut(const map<string, string> &pairs, ConsistencyLevel level);
+	vector<OpHandle> multiGet(const vector<string> &keys);
+	vector<OpHandle> multiGet(const vector<string> &keys, ConsistencyLevel level);
+	vector<OpHandle> multiDelete(const vector<string> &keys);
+	vector<OpHandle> multiDelete(const vector<string> &keys, ConsistencyLevel level);
+	vector<OpHandle> startBatch(MessageType type, const vector<string> &keys, const vector<string> &values, ConsistencyLevel level);
+	void sendBatchFrame(transInfo *trans, Address &to, vector<string> &fields);
+	void serveBatch(Message &m);
+	void sendBatchReply(Message &m, vector<string> &results);
+	void recvBatchReply(Message &m);
+	void decideBatchKey(transInfo *trans, int index);
 
 	// receive messages from Emulnet
 	bool recvLoop();
@@ -97,14 +241,47 @@ public:
 	// find the addresses of nodes that are responsible for a key
 	vector<Node> findNodes(string key);
 
-	// server
+	// server; a key whose time to live ran out reads as missing until it is
+	// reclaimed, on its next write or by the sweep
 	bool createKeyValue(string key, string value, ReplicaType replica);
+	bool createKeyValue(string key, string value, ReplicaType replica, int expiry);
 	string readKey(string key);
+	string readKey(string key, int &timestamp);
+	string readKey(string key, int &timestamp, int &expiry);
 	bool updateKeyValue(string key, string value, ReplicaType replica);
+	bool updateKeyValue(string key, string value, ReplicaType replica, int expiry);
 	bool deletekey(string key);
+	bool expireKey(const string &key);
+	void sweepExpired();
 
 	// stabilization protocol - handle multiple failures
-	void stabilizationProtocol();
+	void stabilizationProtocol(ReplicaTable &oldTable);
+
+	// hand the keys over to their next replicas before leaving the group
+	void handoffKeys();
+
+	// hinted handoff
+	void storeHint(Message &m);
+	void applyHint(Message &m);
+	void replayHints();
+	void confirmHandoff(int id, const string &key);
+
+	// keep the newest of the local and the given version of a key
+	bool applyVersion(const string &key, const string &value, int version, bool deleted, ReplicaType replica, int expiry);
+
+	// Merkle tree anti-entropy
+	static uint64_t versionHash(const string &key, const string &value, int version, bool deleted);
+	uint64_t itemHash(const string &key);
+	MerkleTree *treeOf(const string &key, uint64_t keyHash);
+	void merkleUpdate(const string &key, uint64_t before);
+	void rebuildTrees();
+	bool treePeer(uint64_t token, int replicas, Address &peer);
+	void sendTreeKeys(Address *to, MerkleTree &tree, const string &token, const string &replicas, bool reply, vector<int> &leaves);
+	void sendTreeFrame(Address *to, const string &token, const string &replicas, bool reply, vector<int> &leaves, vector<string> &items);
+	void sendTreeNodes(Address *to, vector<string> &fields);
+	void antiEntropy();
+	void recvTree(Message &m);
+	void recvTreeKeys(Message &m);
 
 	~MP2Node();
 };
@@ -0,0 +1,54 @@
+/**********************************
+ * FILE NAME: MemberListCodec.h
+ *
+ * DESCRIPTION: Header file of the membership list wire codec
+ **********************************/
+
+#ifndef _MEMBERLISTCODEC_H_
+#define _MEMBERLISTCODEC_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Wire format version of the membership payload carried in MessageHdr
+#define ML_WIRE_VERSION 1
+
+/**
+ * CLASS NAME: MemberListCodec
+ *
+ * DESCRIPTION: Compact encoding of a membership list on the wire.
+ * 				Member ids are sorted and grouped into runs of consecutive ids.
+ * 				Every run is written as varint((gap << 1) | hasRun), followed by
+ * 				varint(runLength - 1) when hasRun is set. gap is the distance
+ * 				from the last id of the previous run (or from 0 for the first run).
+ * 				A dense list of N ids therefore costs a handful of bytes and a
+ * 				sparse one about one byte per id.
+ */
+class MemberListCodec {
+public:
+	static void encode(const map<int, int> &ml, vector<unsigned char> &buf);
+	static void encode(const vector<int> &ids, vector<unsigned char> &buf);
+	static void putVarint(vector<unsigned char> &buf, unsigned int value);
+	static bool getVarint(const unsigned char *&pos, const unsigned char *end, unsigned int &value);
+
+	/**
+	 * CLASS NAME: Decoder
+	 *
+	 * DESCRIPTION: Streams the ids back out of an encoded buffer, in ascending order,
+	 * 				without materializing the list
+	 */
+	class Decoder {
+	private:
+		const unsigned char *pos;
+		const unsigned char *end;
+		unsigned int last;
+		unsigned int runLeft;
+	public:
+		Decoder(const unsigned char *data, int size);
+		bool next(int &id);
+	};
+};
+
+#endif /* _MEMBERLISTCODEC_H_ */
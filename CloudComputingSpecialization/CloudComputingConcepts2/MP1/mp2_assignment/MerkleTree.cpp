@@ -0,0 +1,91 @@
+/**********************************
+ * FILE NAME: MerkleTree.cpp
+ *
+ * DESCRIPTION: Definition of the Merkle tree summarizing the keys of one token range
+ **********************************/
+
+#include "MerkleTree.h"
+
+/**
+ * Constructor
+ */
+MerkleTree::MerkleTree(): nodes(2 * MERKLE_LEAVES, 0), keys(MERKLE_LEAVES) {
+	// Empty trees of every node hash the same
+	for ( int i = MERKLE_LEAVES - 1; i >= 1; i-- ) {
+		nodes[i] = combine(nodes[2 * i], nodes[2 * i + 1]);
+	}
+}
+
+/**
+ * FUNCTION NAME: combine
+ *
+ * DESCRIPTION: Hash of an inner node from the hashes of its children
+ */
+uint64_t MerkleTree::combine(uint64_t left, uint64_t right) {
+	uint64_t children[2] = { left, right };
+	return ringHash(children, sizeof(children));
+}
+
+/**
+ * FUNCTION NAME: leafOf
+ *
+ * DESCRIPTION: Returns the node index of the leaf of a key
+ */
+int MerkleTree::leafOf(uint64_t keyHash) {
+	return MERKLE_LEAVES + (int)(keyHash & (MERKLE_LEAVES - 1));
+}
+
+/**
+ * FUNCTION NAME: isLeaf
+ *
+ * DESCRIPTION: Returns true if the node index is a leaf
+ */
+bool MerkleTree::isLeaf(int index) {
+	return index >= MERKLE_LEAVES;
+}
+
+/**
+ * FUNCTION NAME: update
+ *
+ * DESCRIPTION: Replace the item hash of key, 0 for none, and rehash up to the root
+ */
+void MerkleTree::update(const string &key, uint64_t keyHash, uint64_t oldItem, uint64_t newItem) {
+	int index = leafOf(keyHash);
+
+	if ( oldItem == newItem ) {
+		return;
+	}
+
+	nodes[index] ^= oldItem ^ newItem;
+	if ( newItem ) {
+		keys[index - MERKLE_LEAVES].insert(key);
+	}
+	else {
+		keys[index - MERKLE_LEAVES].erase(key);
+	}
+
+	for ( index /= 2; index >= 1; index /= 2 ) {
+		nodes[index] = combine(nodes[2 * index], nodes[2 * index + 1]);
+	}
+}
+
+/**
+ * FUNCTION NAME: hash
+ *
+ * DESCRIPTION: Returns the hash of a node, 0 for an index outside the tree
+ */
+uint64_t MerkleTree::hash(int index) const {
+	if ( index < 1 || index >= 2 * MERKLE_LEAVES ) {
+		return 0;
+	}
+	return nodes[index];
+}
+
+/**
+ * FUNCTION NAME: leafKeys
+ *
+ * DESCRIPTION: Returns the keys under a leaf
+ */
+const set<string> &MerkleTree::leafKeys(int index) const {
+	return keys[index - MERKLE_LEAVES];
+}
@@ -0,0 +1,49 @@
+/**********************************
+ * FILE NAME: MerkleTree.h
+ *
+ * DESCRIPTION: Header file of the Merkle tree summarizing the keys of one token range
+ **********************************/
+
+#ifndef MERKLETREE_H_
+#define MERKLETREE_H_
+
+#include "stdincludes.h"
+#include "RingHash.h"
+#include <set>
+
+/*
+ * Macros
+ */
+// A tree has 2^MERKLE_DEPTH leaves
+#define MERKLE_DEPTH 8
+#define MERKLE_LEAVES (1 << MERKLE_DEPTH)
+
+/**
+ * CLASS NAME: MerkleTree
+ *
+ * DESCRIPTION: Complete binary tree of hashes stored heap style: the root is
+ * 				node 1 and the children of node i are 2i and 2i + 1. A key
+ * 				falls in the leaf picked by the low bits of its ring position.
+ * 				A leaf is the XOR of the hashes of its items, so a write is
+ * 				folded in by XOR-ing out the old item and XOR-ing in the new
+ * 				one, then rehashing the MERKLE_DEPTH nodes above the leaf.
+ */
+class MerkleTree {
+private:
+	vector<uint64_t> nodes;
+	// keys held under each leaf
+	vector<set<string> > keys;
+
+	static uint64_t combine(uint64_t left, uint64_t right);
+
+public:
+	MerkleTree();
+	static int leafOf(uint64_t keyHash);
+	static bool isLeaf(int index);
+	void update(const string &key, uint64_t keyHash, uint64_t oldItem, uint64_t newItem);
+	uint64_t hash(int index) const;
+	const set<string> &leafKeys(int index) const;
+	virtual ~MerkleTree() {}
+};
+
+#endif /* MERKLETREE_H_ */
@@ -8,14 +8,28 @@
 /**
  * Constructor
  */
-// transID::fromAddr::CREATE::key::value::ReplicaType
+// transID::fromAddr::CREATE::key::value::ReplicaType[::expiry]
 // transID::fromAddr::READ::key
-// transID::fromAddr::UPDATE::key::value::ReplicaType
+// transID::fromAddr::UPDATE::key::value::ReplicaType[::expiry]
 // transID::fromAddr::DELETE::key
-// transID::fromAddr::REPLY::sucess
-// transID::fromAddr::READREPLY::value
+// transID::fromAddr::REPLY::sucess::timestamp
+// transID::fromAddr::READREPLY::value::timestamp[::expiry]
+// transID::fromAddr::HINT::key::value::ReplicaType::hintFor::hintType::timestamp[::expiry]
+// transID::fromAddr::HINTACK::key
+// transID::fromAddr::TREE::token::rf::index::hash...
+// transID::fromAddr::TREEKEYS::token::rf::reply::leafCount::leaf...::key::value::version::deleted::expiry...
+// transID::fromAddr::DIGEST::key
+// transID::fromAddr::DIGESTREPLY::digest::version
+// transID::fromAddr::BATCH::type::frame::key::value::ReplicaType...
+// transID::fromAddr::BATCHREPLY::frame::first::success::value::timestamp...
+// transID::fromAddr::SCAN::from::after::end::lo::hi::limit
+// transID::fromAddr::SCANREPLY::more::key::value::timestamp...
+// transID::fromAddr::LOAD::key::value::ReplicaType...
+// transID::fromAddr::LOADACK::count
 Message::Message(string message){
 	this->delimiter = "::";
+	expiry = 0;
+	timestamp = 0;
 	vector<string> tuple;
 	size_t pos = message.find(delimiter);
 	size_t start = 0;
@@ -27,7 +41,7 @@ Message::Message(string message){
 	}
 	tuple.push_back(message.substr(start));
 
-	transID = stoi(tuple.at(0));
+	transID = stoll(tuple.at(0));
 	Address addr(tuple.at(1));
 	fromAddr = addr;
 	type = static_cast<MessageType>(stoi(tuple.at(2)));
@@ -38,9 +52,12 @@ Message::Message(string message){
 			value = tuple.at(4);
 			if (tuple.size() > 5)
 				replica = static_cast<ReplicaType>(stoi(tuple.at(5)));
+			if (tuple.size() > 6)
+				expiry = stoi(tuple.at(6));
 			break;
 		case READ:
 		case DELETE:
+		case DIGEST:
 			key = tuple.at(3);
 			break;
 		case REPLY:
@@ -48,9 +65,39 @@ Message::Message(string message){
 				success = true;
 			else
 				success = false;
+			if (tuple.size() > 4)
+				timestamp = stoi(tuple.at(4));
 			break;
 		case READREPLY:
 			value = tuple.at(3);
+			if (tuple.size() > 4)
+				timestamp = stoi(tuple.at(4));
+			if (tuple.size() > 5)
+				expiry = stoi(tuple.at(5));
+			break;
+		case HINT:
+			key = tuple.at(3);
+			value = tuple.at(4);
+			replica = static_cast<ReplicaType>(stoi(tuple.at(5)));
+			hintFor = Address(tuple.at(6));
+			hintType = static_cast<MessageType>(stoi(tuple.at(7)));
+			timestamp = stoi(tuple.at(8));
+			if (tuple.size() > 9)
+				expiry = stoi(tuple.at(9));
+			break;
+		case HINTACK:
+			key = tuple.at(3);
+			break;
+		case TREE:
+		case TREEKEYS:
+		case DIGESTREPLY:
+		case BATCH:
+		case BATCHREPLY:
+		case SCAN:
+		case SCANREPLY:
+		case LOAD:
+		case LOADACK:
+			fields.assign(tuple.begin() + 3, tuple.end());
 			break;
 	}
 }
@@ -59,8 +106,9 @@ Message::Message(string message){
  * Constructor
  */
 // construct a create or update message
-Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica){
+Message::Message(TransID _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica){
 	this->delimiter = "::";
+	expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
@@ -81,13 +129,19 @@ Message::Message(const Message& anotherMessage) {
 	this->transID = anotherMessage.transID;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
+	this->hintFor = anotherMessage.hintFor;
+	this->hintType = anotherMessage.hintType;
+	this->timestamp = anotherMessage.timestamp;
+	this->expiry = anotherMessage.expiry;
+	this->fields = anotherMessage.fields;
 }
 
 /**
  * Constructor
  */
-Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value){
+Message::Message(TransID _transID, Address _fromAddr, MessageType _type, string _key, string _value){
 	this->delimiter = "::";
+	expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
@@ -99,8 +153,9 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
  * Constructor
  */
 // construct a read or delete message
-Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key){
+Message::Message(TransID _transID, Address _fromAddr, MessageType _type, string _key){
 	this->delimiter = "::";
+	expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
@@ -111,24 +166,74 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
  * Constructor
  */
 // construct reply message
-Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _success){
+Message::Message(TransID _transID, Address _fromAddr, MessageType _type, bool _success){
 	this->delimiter = "::";
+	expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = _type;
 	success = _success;
+	timestamp = 0;
 }
 
 /**
  * Constructor
  */
 // construct read reply message
-Message::Message(int _transID, Address _fromAddr, string _value){
+Message::Message(TransID _transID, Address _fromAddr, string _value){
 	this->delimiter = "::";
+	expiry = 0;
 	transID = _transID;
 	fromAddr = _fromAddr;
 	type = READREPLY;
 	value = _value;
+	timestamp = 0;
+}
+
+/**
+ * Constructor
+ */
+// construct read reply message carrying the version of the value
+Message::Message(TransID _transID, Address _fromAddr, string _value, int _timestamp){
+	this->delimiter = "::";
+	expiry = 0;
+	transID = _transID;
+	fromAddr = _fromAddr;
+	type = READREPLY;
+	value = _value;
+	timestamp = _timestamp;
+}
+
+/**
+ * Constructor
+ */
+// construct anti-entropy message
+Message::Message(TransID _transID, Address _fromAddr, MessageType _type, const vector<string> &_fields){
+	this->delimiter = "::";
+	expiry = 0;
+	transID = _transID;
+	fromAddr = _fromAddr;
+	type = _type;
+	fields = _fields;
+	timestamp = 0;
+}
+
+/**
+ * Constructor
+ */
+// construct hinted write message
+Message::Message(TransID _transID, Address _fromAddr, string _key, string _value, ReplicaType _replica, Address _hintFor, MessageType _hintType, int _timestamp){
+	this->delimiter = "::";
+	expiry = 0;
+	transID = _transID;
+	fromAddr = _fromAddr;
+	type = HINT;
+	key = _key;
+	value = _value;
+	replica = _replica;
+	hintFor = _hintFor;
+	hintType = _hintType;
+	timestamp = _timestamp;
 }
 
 /**
@@ -142,9 +247,12 @@ string Message::toString(){
 		case CREATE:
 		case UPDATE:
 			message += key + delimiter + value + delimiter + to_string(replica);
+			if (expiry != 0)
+				message += delimiter + to_string(expiry);
 			break;
 		case READ:
 		case DELETE:
+		case DIGEST:
 			message += key;
 			break;
 		case REPLY:
@@ -152,9 +260,33 @@ string Message::toString(){
 				message += "1";
 			else
 				message += "0";
+			message += delimiter + to_string(timestamp);
 			break;
 		case READREPLY:
-			message += value;
+			message += value + delimiter + to_string(timestamp);
+			if (expiry != 0)
+				message += delimiter + to_string(expiry);
+			break;
+		case HINT:
+			message += key + delimiter + value + delimiter + to_string(replica) + delimiter + hintFor.getAddress() + delimiter + to_string(hintType) + delimiter + to_string(timestamp);
+			if (expiry != 0)
+				message += delimiter + to_string(expiry);
+			break;
+		case HINTACK:
+			message += key;
+			break;
+		case TREE:
+		case TREEKEYS:
+		case DIGESTREPLY:
+		case BATCH:
+		case BATCHREPLY:
+		case SCAN:
+		case SCANREPLY:
+		case LOAD:
+		case LOADACK:
+			for (size_t i = 0; i < fields.size(); i++) {
+				message += (i ? delimiter : "") + fields[i];
+			}
 			break;
 	}
 	return message;
@@ -172,5 +304,10 @@ Message& Message::operator =(const Message& anotherMessage) {
 	this->transID = anotherMessage.transID;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
+	this->hintFor = anotherMessage.hintFor;
+	this->hintType = anotherMessage.hintType;
+	this->timestamp = anotherMessage.timestamp;
+	this->expiry = anotherMessage.expiry;
+	this->fields = anotherMessage.fields;
 	return *this;
 }
@@ -22,22 +22,36 @@ public:
 	string key;
 	string value;
 	Address fromAddr;
-	int transID;
+	TransID transID;
 	bool success; // success or not 
+	// replica a hinted write is meant for, and the write it holds
+	Address hintFor;
+	MessageType hintType;
+	// version (Entry timestamp) of a read reply, hinted write, or the write a reply confirms
+	int timestamp;
+	// time a created, updated, hinted or read value expires at, 0 if it never does
+	int expiry;
+	// anti-entropy, digest reply and batch payload
+	vector<string> fields;
 	// delimiter
 	string delimiter;
 	// construct a message from a string
 	Message(string message);
 	Message(const Message& anotherMessage);
 	// construct a create or update message
-	Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value);
-	Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica);
+	Message(TransID _transID, Address _fromAddr, MessageType _type, string _key, string _value);
+	Message(TransID _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica);
 	// construct a read or delete message
-	Message(int _transID, Address _fromAddr, MessageType _type, string _key);
+	Message(TransID _transID, Address _fromAddr, MessageType _type, string _key);
 	// construct reply message
-	Message(int _transID, Address _fromAddr, MessageType _type, bool _success);
+	Message(TransID _transID, Address _fromAddr, MessageType _type, bool _success);
 	// construct read reply message
-	Message(int _transID, Address _fromAddr, string _value);
+	Message(TransID _transID, Address _fromAddr, string _value);
+	Message(TransID _transID, Address _fromAddr, string _value, int _timestamp);
+	// construct anti-entropy, digest reply or batch message
+	Message(TransID _transID, Address _fromAddr, MessageType _type, const vector<string> &_fields);
+	// construct hinted write message
+	Message(TransID _transID, Address _fromAddr, string _key, string _value, ReplicaType _replica, Address _hintFor, MessageType _hintType, int _timestamp);
 	Message& operator = (const Message& anotherMessage);
 	// serialize to a string
 	string toString();
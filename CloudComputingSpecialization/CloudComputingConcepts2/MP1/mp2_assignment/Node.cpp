@@ -19,6 +19,14 @@ Node::Node(Address address) {
 	computeHashCode();
 }
 
+/**
+ * constructor of the token-th virtual node of address
+ */
+Node::Node(Address address, int token) {
+	this->nodeAddress = address;
+	computeHashCode(token);
+}
+
 /**
  * Destructor
  */
@@ -30,7 +38,28 @@ Node::~Node() {}
  * DESCRIPTION: This function computes the hash code of the node address
  */
 void Node::computeHashCode() {
-	nodeHashCode = hashFunc(nodeAddress.addr)%RING_SIZE;
+	computeHashCode(0);
+}
+
+/**
+ * FUNCTION NAME: computeHashCode
+ *
+ * DESCRIPTION: This function computes the position of a virtual node of the node address.
+ * 				The id, port and token are hashed as little endian integers.
+ */
+void Node::computeHashCode(int token) {
+	unsigned char key[10];
+	int id = *(int *)(&nodeAddress.addr[0]);
+	short port = *(short *)(&nodeAddress.addr[4]);
+
+	for ( int i = 0; i < 4; i++ ) {
+		key[i] = (unsigned char)(id >> (8 * i));
+		key[6 + i] = (unsigned char)(token >> (8 * i));
+	}
+	key[4] = (unsigned char)port;
+	key[5] = (unsigned char)(port >> 8);
+
+	nodeHashCode = ringHash(key, sizeof(key));
 }
 
 /**
@@ -54,7 +83,11 @@ Node& Node::operator=(const Node& another) {
  * operator overloading
  */
 bool Node::operator < (const Node& another) const {
-	return this->nodeHashCode < another.nodeHashCode;
+	if ( this->nodeHashCode != another.nodeHashCode ) {
+		return this->nodeHashCode < another.nodeHashCode;
+	}
+	// nodes hashed to the same position are kept in a stable order
+	return memcmp(this->nodeAddress.addr, another.nodeAddress.addr, sizeof(this->nodeAddress.addr)) < 0;
 }
 
 /**
@@ -62,7 +95,7 @@ bool Node::operator < (const Node& another) const {
  *
  * DESCRIPTION: return hash code of the node
  */
-size_t Node::getHashCode() {
+uint64_t Node::getHashCode() {
 	return nodeHashCode;
 }
 
@@ -80,7 +113,7 @@ Address * Node::getAddress() {
  *
  * DESCRIPTION: set the hash code of the node
  */
-void Node::setHashCode(size_t hashCode) {
+void Node::setHashCode(uint64_t hashCode) {
 	this->nodeHashCode = hashCode;
 }
 
@@ -0,0 +1,103 @@
+/**********************************
+ * FILE NAME: Overlay.h
+ *
+ * DESCRIPTION: Header file of the pluggable membership overlay interface
+ * 				and of the wire format shared by the overlay messages
+ **********************************/
+
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "EmulNet.h"
+
+/*
+ * Macros
+ */
+// Wire format version of ViewMsgHdr
+#define VIEW_WIRE_VERSION 1
+// Overlay message types are numbered after MP1Node's MsgTypes so that both
+// can travel on the same queue and be told apart by their first byte
+#define OVERLAY_MSGTYPE_BASE 16
+
+/**
+ * Message Types
+ */
+enum ViewMsgTypes {
+	VIEWJOIN = OVERLAY_MSGTYPE_BASE,
+	FORWARDJOIN,
+	NEIGHBOR,
+	NEIGHBORREPLY,
+	DISCONNECT,
+	SHUFFLE,
+	SHUFFLEREPLY,
+	VIEWPING,
+	VIEWPONG,
+	RINGEVENT,
+	RINGSYNC
+};
+
+/**
+ * STRUCT NAME: ViewMsgHdr
+ *
+ * DESCRIPTION: Header and content of an overlay message.
+ * 				subject, ttl and flag are interpreted per message type; ml carries
+ * 				size bytes of message type specific payload.
+ */
+typedef struct ViewMsgHdr {
+	unsigned char msgType;
+	unsigned char version;
+	Address fromAddr;
+	int subject;
+	short ttl;
+	short flag;
+	int size;
+	unsigned char ml[1];
+} ViewMsgHdr;
+
+// Size of the fixed part of an overlay message
+#define VIEWMSGHDR_SIZE offsetof(ViewMsgHdr, ml)
+
+Address overlayAddress(int id);
+int overlayId(Address *addr);
+ViewMsgHdr *parseViewMessage(char *data, int size);
+void sendViewMessage(EmulNet *emulNet, Address *from, int to, unsigned char msgType, int subject, short ttl, short flag, const vector<unsigned char> &payload);
+
+/**
+ * CLASS NAME: OverlayListener
+ *
+ * DESCRIPTION: Notified by an Overlay when its neighborhood changes
+ */
+class OverlayListener {
+public:
+	// id became a neighbor
+	virtual void onNeighborUp(int id) = 0;
+	// id is no longer a neighbor; failed is set when it stopped answering
+	virtual void onNeighborDown(int id, bool failed) = 0;
+	// id asked this node to introduce it to the group
+	virtual void onJoinRequest(int id) = 0;
+	virtual ~OverlayListener() {}
+};
+
+/**
+ * CLASS NAME: Overlay
+ *
+ * DESCRIPTION: Membership overlay that keeps each node connected to a
+ * 				subset of the group. The owner feeds it the messages it
+ * 				recognizes and calls tick once per period.
+ */
+class Overlay {
+public:
+	virtual void setListener(OverlayListener *listener) = 0;
+	virtual void join(Address *contact) = 0;
+	// Disconnect from every neighbor before shutting down
+	virtual void leave() = 0;
+	// Returns false if the message is not an overlay message
+	virtual bool recv(char *data, int size) = 0;
+	virtual void tick() = 0;
+	virtual void neighbors(vector<int> &ids) = 0;
+	virtual ~Overlay() {}
+};
+
+#endif /* _OVERLAY_H_ */
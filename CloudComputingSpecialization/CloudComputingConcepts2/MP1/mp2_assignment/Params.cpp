@@ -40,11 +40,54 @@ void Params::setparams(char *config_file) {
 		this->CRUDTEST = DELETE_TEST;
 	}
 
+	/*
+	 * Optional settings
+	 */
+	PARTIAL_VIEW = 0;
+	ACTIVE_VIEW_SIZE = 0;
+	PASSIVE_VIEW_SIZE = 0;
+	SHUFFLE_PERIOD = 10;
+	RING_SYNC_PERIOD = 5;
+	SEEDS.assign(1, 1);
+	JOIN_TIMEOUT = 5;
+	JOIN_BATCH = 0;
+	GRACEFUL_LEAVE = 0;
+	MAX_INFLIGHT = 0;
+	VNODES = 1;
+	WEIGHTS.clear();
+	HASH_SEED = 0;
+	REPLICATION_FACTOR = 3;
+	KEYSPACES.clear();
+	READ_CONSISTENCY = QUORUM;
+	WRITE_CONSISTENCY = QUORUM;
+	HINTED_HANDOFF = 0;
+	HINT_RETRY = 5;
+	READ_REPAIR = 1;
+	ANTI_ENTROPY_PERIOD = 0;
+	TOMBSTONE_TIME = 100;
+	DIGEST_READS = 0;
+	HEDGED_READS = 0;
+	HEDGE_PERCENTILE = 95;
+	BATCH_SIZE = 0;
+	REPLICA_WINDOW = 0;
+	ORDERED_PARTITIONER = 0;
+	SCAN_PAGE = 16;
+	BULK_LOAD = 0;
+	TTL_SWEEP = 16;
+	COUNTER_CLIENTS = 0;
+
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
 	STEP_RATE=.25;
 	MAX_MSG_SIZE = 4000;
+
+	// Optional settings may override the defaults above
+	char name[64];
+	char value[64];
+	while ( fscanf(fp, " %63[^:]: %63s", name, value) == 2 ) {
+		setoption(name, value);
+	}
 	globaltime = 0;
 	dropmsg = 0;
 	allNodesJoined = 0;
@@ -56,6 +99,151 @@ void Params::setparams(char *config_file) {
 	return;
 }
 
+/**
+ * FUNCTION NAME: consistencyLevel
+ *
+ * DESCRIPTION: Parse ONE, QUORUM or ALL, anything else is QUORUM
+ */
+static ConsistencyLevel consistencyLevel(char *value) {
+	if ( 0 == strcmp(value, "ONE") ) {
+		return ONE;
+	}
+	else if ( 0 == strcmp(value, "ALL") ) {
+		return ALL;
+	}
+	return QUORUM;
+}
+
+/**
+ * FUNCTION NAME: setoption
+ *
+ * DESCRIPTION: Set one optional parameter. Unknown names are ignored.
+ */
+void Params::setoption(char *name, char *value) {
+	if ( 0 == strcmp(name, "PARTIAL_VIEW") ) {
+		PARTIAL_VIEW = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "ACTIVE_VIEW_SIZE") ) {
+		ACTIVE_VIEW_SIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "PASSIVE_VIEW_SIZE") ) {
+		PASSIVE_VIEW_SIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "SHUFFLE_PERIOD") ) {
+		SHUFFLE_PERIOD = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "RING_SYNC_PERIOD") ) {
+		RING_SYNC_PERIOD = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "SEEDS") ) {
+		// comma separated list of node ids
+		SEEDS.clear();
+		for ( char *id = strtok(value, ","); id; id = strtok(NULL, ",") ) {
+			if ( atoi(id) > 0 ) {
+				SEEDS.push_back(atoi(id));
+			}
+		}
+		if ( SEEDS.empty() ) {
+			SEEDS.assign(1, 1);
+		}
+	}
+	else if ( 0 == strcmp(name, "JOIN_TIMEOUT") ) {
+		JOIN_TIMEOUT = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "JOIN_BATCH") ) {
+		JOIN_BATCH = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "GRACEFUL_LEAVE") ) {
+		GRACEFUL_LEAVE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "VNODES") ) {
+		VNODES = max(1, atoi(value));
+	}
+	else if ( 0 == strcmp(name, "WEIGHTS") ) {
+		// comma separated list of id:weight
+		WEIGHTS.clear();
+		for ( char *item = strtok(value, ","); item; item = strtok(NULL, ",") ) {
+			char *weight = strchr(item, ':');
+			if ( weight && atoi(item) > 0 ) {
+				WEIGHTS[atoi(item)] = atof(weight + 1);
+			}
+		}
+	}
+	else if ( 0 == strcmp(name, "HASH_SEED") ) {
+		HASH_SEED = strtoull(value, NULL, 0);
+	}
+	else if ( 0 == strcmp(name, "REPLICATION_FACTOR") ) {
+		REPLICATION_FACTOR = max(1, atoi(value));
+	}
+	else if ( 0 == strcmp(name, "KEYSPACES") ) {
+		// comma separated list of name:rf, the keyspace of a key is the text before its first ':'
+		KEYSPACES.clear();
+		for ( char *item = strtok(value, ","); item; item = strtok(NULL, ",") ) {
+			char *rf = strchr(item, ':');
+			if ( rf && rf != item ) {
+				KEYSPACES[string(item, rf)] = max(1, atoi(rf + 1));
+			}
+		}
+	}
+	else if ( 0 == strcmp(name, "READ_CONSISTENCY") ) {
+		READ_CONSISTENCY = consistencyLevel(value);
+	}
+	else if ( 0 == strcmp(name, "WRITE_CONSISTENCY") ) {
+		WRITE_CONSISTENCY = consistencyLevel(value);
+	}
+	else if ( 0 == strcmp(name, "HINTED_HANDOFF") ) {
+		HINTED_HANDOFF = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "HINT_RETRY") ) {
+		HINT_RETRY = max(1, atoi(value));
+	}
+	else if ( 0 == strcmp(name, "READ_REPAIR") ) {
+		READ_REPAIR = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "ANTI_ENTROPY_PERIOD") ) {
+		ANTI_ENTROPY_PERIOD = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "TOMBSTONE_TIME") ) {
+		TOMBSTONE_TIME = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "DIGEST_READS") ) {
+		DIGEST_READS = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "HEDGED_READS") ) {
+		HEDGED_READS = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "HEDGE_PERCENTILE") ) {
+		HEDGE_PERCENTILE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "BATCH_SIZE") ) {
+		BATCH_SIZE = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "REPLICA_WINDOW") ) {
+		REPLICA_WINDOW = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "ORDERED_PARTITIONER") ) {
+		ORDERED_PARTITIONER = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "SCAN_PAGE") ) {
+		SCAN_PAGE = max(1, atoi(value));
+	}
+	else if ( 0 == strcmp(name, "BULK_LOAD") ) {
+		BULK_LOAD = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "TTL_SWEEP") ) {
+		TTL_SWEEP = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "COUNTER_CLIENTS") ) {
+		COUNTER_CLIENTS = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "MAX_INFLIGHT") ) {
+		MAX_INFLIGHT = atoi(value);
+	}
+	else if ( 0 == strcmp(name, "STEP_RATE") ) {
+		STEP_RATE = atof(value);
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
@@ -10,6 +10,7 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "common.h"
 
 enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
 
@@ -32,8 +33,42 @@ public:
 	int allNodesJoined;
 	short PORTNUM;
 	int CRUDTEST;
+	// Optional settings, given as extra "NAME: value" lines in the test case file
+	int PARTIAL_VIEW;           // use HyParView partial views instead of full membership
+	int ACTIVE_VIEW_SIZE;       // HyParView active view size, 0 to derive from EN_GPSZ
+	int PASSIVE_VIEW_SIZE;      // HyParView passive view size, 0 to derive from EN_GPSZ
+	int SHUFFLE_PERIOD;         // ticks between HyParView shuffles
+	int RING_SYNC_PERIOD;       // ticks between ring anti-entropy pushes
+	vector<int> SEEDS;          // introducer node ids, the first one boots the group
+	int JOIN_TIMEOUT;           // ticks to wait for an introducer before trying the next one
+	int JOIN_BATCH;             // max joins an introducer answers per tick, 0 for no limit
+	int MAX_INFLIGHT;           // messages the emulated network holds at once, 0 for ENBUFFSIZE
+	int GRACEFUL_LEAVE;         // stopped nodes leave the group (and hand off their keys) instead of crashing
+	int VNODES;                 // tokens per node on the key-value store ring
+	map<int, double> WEIGHTS;   // per node id multiplier of VNODES, given as "id:weight,..."
+	unsigned long long HASH_SEED; // seed of the ring hash, the same on every node
+	int REPLICATION_FACTOR;     // replicas of a key outside the keyspaces listed in KEYSPACES
+	map<string, int> KEYSPACES; // per keyspace replication factor, given as "name:rf,..."
+	ConsistencyLevel READ_CONSISTENCY;  // level of reads that do not give one
+	ConsistencyLevel WRITE_CONSISTENCY; // level of creates, updates and deletes that do not give one
+	int HINTED_HANDOFF;         // write to the next healthy node, with a hint, in place of an unresponsive replica
+	int HINT_RETRY;             // ticks between replays of a hint to its replica
+	int READ_REPAIR;            // push the newest value read to the replicas that answered with an older one
+	int ANTI_ENTROPY_PERIOD;    // ticks between Merkle tree exchanges of neighboring replicas, 0 for none
+	int TOMBSTONE_TIME;         // ticks a deleted key is remembered for anti-entropy
+	int DIGEST_READS;           // one replica returns the value, the others a digest of it
+	int HEDGED_READS;           // reads go to the fastest replicas, the others only when they are late
+	int HEDGE_PERCENTILE;       // percentile of recent reply times after which a read is hedged
+	int BATCH_SIZE;             // keys the create and delete tests send per multiPut/multiDelete, 0 for one at a time
+	int REPLICA_WINDOW;         // requests a coordinator has on their way to one replica, the rest queued; 0 for no limit
+	int ORDERED_PARTITIONER;    // keys placed on the ring in key order, for range scans, instead of by hash
+	int SCAN_PAGE;              // keys a replica returns per page of a range scan
+	int BULK_LOAD;              // the test keys are inserted by one bulk load instead of a create each
+	int TTL_SWEEP;              // keys checked per tick for an expired time to live, 0 to reclaim them on access only
+	int COUNTER_CLIENTS;        // read-modify-write clients Application runs as KVTasks next to the tests
 	Params();
 	void setparams(char *);
+	void setoption(char *name, char *value);
 	int getcurrtime();
 };
 
@@ -0,0 +1,109 @@
+/**********************************
+ * FILE NAME: PendingTable.cpp
+ *
+ * DESCRIPTION: Definition of the table of the transactions a coordinator waits on
+ **********************************/
+
+#include "PendingTable.h"
+
+/**
+ * Constructor
+ */
+PendingTable::PendingTable(): active(0), prefix(0), nextSequence(1) {}
+
+/**
+ * FUNCTION NAME: setOwner
+ *
+ * DESCRIPTION: Set the node id and the epoch the ids of the table carry. The
+ * 				epoch tells a restarted node apart from its earlier self, so
+ * 				a reply to a transaction it opened before is not mistaken
+ * 				for one it opened since.
+ */
+void PendingTable::setOwner(int node, int epoch) {
+	prefix = ((TransID)(node & ((1 << PENDING_NODE_BITS) - 1)) << (PENDING_EPOCH_BITS + PENDING_SEQUENCE_BITS + PENDING_SLOT_BITS)) |
+			 ((TransID)(epoch & ((1 << PENDING_EPOCH_BITS) - 1)) << (PENDING_SEQUENCE_BITS + PENDING_SLOT_BITS));
+}
+
+/**
+ * FUNCTION NAME: open
+ *
+ * DESCRIPTION: Open a transaction in a free slot, or a new one while fewer than
+ * 				PENDING_SLOTS exist, with the next sequence number
+ *
+ * RETURNS:
+ * the cleared transInfo, its id set; NULL if every slot is open or every
+ * sequence number was used
+ */
+transInfo *PendingTable::open() {
+	int index;
+
+	if ( nextSequence >= PENDING_SEQUENCES ) {
+		return NULL;
+	}
+	if ( !freeSlots.empty() ) {
+		index = freeSlots.front();
+		freeSlots.pop_front();
+	}
+	else if ( slots.size() < PENDING_SLOTS ) {
+		index = (int)slots.size();
+		slots.push_back(Slot());
+	}
+	else {
+		return NULL;
+	}
+
+	Slot &slot = slots[index];
+	slot.open = true;
+	slot.trans = transInfo();
+	// Sequence numbers start at 1, so no id is 0
+	slot.trans.id = prefix | ((TransID)nextSequence++ << PENDING_SLOT_BITS) | index;
+	active++;
+	return &slot.trans;
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Returns the open transaction with the given id, NULL if it was
+ * 				closed or never opened
+ */
+transInfo *PendingTable::find(TransID id) {
+	int index = (int)(id & (PENDING_SLOTS - 1));
+	TransID owner = ~((PENDING_SEQUENCES << PENDING_SLOT_BITS) - 1);
+
+	if ( (id & owner) != prefix || index >= (int)slots.size() ) {
+		return NULL;
+	}
+
+	Slot &slot = slots[index];
+	if ( !slot.open || slot.trans.id != id ) {
+		return NULL;
+	}
+	return &slot.trans;
+}
+
+/**
+ * FUNCTION NAME: close
+ *
+ * DESCRIPTION: Close a transaction and free its slot
+ */
+void PendingTable::close(transInfo *trans) {
+	int index = (int)(trans->id & (PENDING_SLOTS - 1));
+	Slot &slot = slots[index];
+
+	if ( !slot.open ) {
+		return;
+	}
+	slot.open = false;
+	freeSlots.push_back(index);
+	active--;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of open transactions
+ */
+unsigned long PendingTable::size() {
+	return active;
+}
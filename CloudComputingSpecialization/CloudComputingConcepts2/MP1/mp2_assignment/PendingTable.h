@@ -0,0 +1,195 @@
+/**********************************
+ * FILE NAME: PendingTable.h
+ *
+ * DESCRIPTION: Header file of the table of the transactions a coordinator waits on
+ **********************************/
+
+#ifndef PENDINGTABLE_H_
+#define PENDINGTABLE_H_
+
+#include "stdincludes.h"
+#include "common.h"
+#include "TimingWheel.h"
+#include "ReplicaTable.h"
+#include <deque>
+#include <memory>
+#include <functional>
+
+/*
+ * Macros
+ */
+// A transaction id is, from the top, a clear sign bit, the node id of the
+// coordinator (PENDING_NODE_BITS, node ids are below MAX_NODES), its epoch
+// (PENDING_EPOCH_BITS, the tick it started at, below MAX_TIME), the sequence
+// number of the transaction and its slot (PENDING_SLOT_BITS). Every
+// transaction a node opens takes the next sequence number, which never
+// wraps: once PENDING_SEQUENCES are used up opening fails. A node has at
+// most PENDING_SLOTS open transactions.
+#define PENDING_NODE_BITS 10
+#define PENDING_EPOCH_BITS 12
+#define PENDING_SLOT_BITS 16
+#define PENDING_SEQUENCE_BITS (63 - PENDING_NODE_BITS - PENDING_EPOCH_BITS - PENDING_SLOT_BITS)
+#define PENDING_SLOTS (1 << PENDING_SLOT_BITS)
+#define PENDING_SEQUENCES (1LL << PENDING_SEQUENCE_BITS)
+
+// Outcome of a client operation, filled in once the coordinator decides it
+typedef struct OpResult
+{
+	TransID transID;
+	MessageType type;
+	string key;
+	bool done;
+	bool success;
+	// the value read, or written
+	string value;
+	// version of the value read, or the newest a replica wrote; -1 for none
+	int version;
+	// scan: the keys found, in key order, and their values
+	vector<pair<string, string> > rows;
+	// time of the request, and ticks it took to decide
+	int start;
+	int latency;
+	// called once when the operation is decided, if set by then
+	function<void(const struct OpResult &)> callback;
+} OpResult;
+
+typedef shared_ptr<OpResult> OpHandle;
+
+// One key of a batch and its replies
+typedef struct BatchKey
+{
+	string key;
+	string value;
+	int replicas;
+	int needed;
+	int numSucc;
+	int numFail;
+	bool decided;
+	// the newest value replied and its version; writes only have a version
+	string newest;
+	int newestVersion;
+	OpHandle handle;
+} BatchKey;
+
+// One BATCH frame: the node it went to, the indices of its keys in the batch,
+// which of them the node answered, and how many it did not yet
+typedef struct BatchFrame
+{
+	int node;
+	vector<int> keys;
+	vector<bool> answered;
+	int left;
+} BatchFrame;
+
+typedef struct transInfo
+{
+	// transaction id, see PendingTable
+	TransID id;
+	MessageType type;
+	string key;
+	string value;
+	int timestamp;
+	int numSucc;
+	int numFail;
+	// replicas asked, and successful replies that decide the transaction
+	int replicas;
+	int needed;
+	// ring position of key, hashed once when the request is made
+	uint64_t keyHash;
+	TimingWheel::TimerId timer;
+	// replicas of the key, a bit per node the request went to, and per node
+	// that answered, and when it went to each
+	ReplicaSet asked;
+	unsigned int sent;
+	unsigned int answered;
+	int sentAt[MAX_REPLICAS];
+	// read: timer that sends it to the replicas left out (HEDGED_READS)
+	TimingWheel::TimerId hedgeTimer;
+	// logged, kept until the timeout only to see who never answers
+	// or, for a read, who needs repair
+	bool decided;
+	bool succeeded;
+	// read: version each node answered with, -1 for no value, and the newest
+	// value; a write only keeps the newest version a replica wrote
+	int versions[MAX_REPLICAS];
+	string newest;
+	int newestVersion;
+	// time the value written expires at, or for a read that of the newest
+	// value, 0 if it never does
+	int expiry;
+	// digest read: the node asked for the value, the digests, and bits of the
+	// nodes that sent a digest, were counted, or were asked for their value since
+	int fullIndex;
+	uint64_t digests[MAX_REPLICAS];
+	unsigned int digested;
+	unsigned int counted;
+	unsigned int fetching;
+	bool haveFull;
+	// read: bits of the nodes asked for the value itself, not a digest
+	unsigned int valueAsked;
+	// batch: its keys, the frames not fully answered yet, by frame number, and
+	// the number of keys not decided
+	vector<BatchKey> batch;
+	map<int, BatchFrame> batchFrames;
+	int batchLeft;
+	// requests waiting in replica windows, and the tick the last of them went
+	// out, from which the timeout counts (REPLICA_WINDOW)
+	int held;
+	int lastSent;
+	// scan: key the next page starts at and whether that key was returned
+	// already, key the scan stops before, "" for none, keys still wanted,
+	// and the ring positions of the range paged through
+	string scanFrom;
+	bool scanAfter;
+	string scanEnd;
+	int scanLeft;
+	uint64_t scanLo;
+	uint64_t scanHi;
+	// bulk load: keys and bytes of the stream, keys the replicas acknowledged,
+	// and the wall clock time it started, in seconds
+	int loadKeys;
+	long loadBytes;
+	long loadAcked;
+	double loadStart;
+	// handed to the client, completed with the decision
+	OpHandle handle;
+} transInfo;
+
+/**
+ * CLASS NAME: PendingTable
+ *
+ * DESCRIPTION: Slab of transInfo indexed by the slot carried in the transaction
+ * 				id. Opening, finding and closing a transaction are O(1). No
+ * 				two transactions of a node share a sequence number, and find
+ * 				matches the whole id a slot was opened with, so a late reply
+ * 				to a closed transaction finds nothing even once the slot holds
+ * 				another one. Freed slots are reused oldest first, so a slot is
+ * 				not opened again while others are free. Slots never move, so
+ * 				a transInfo pointer stays valid until its transaction is closed.
+ */
+class PendingTable {
+private:
+	typedef struct Slot {
+		transInfo trans;
+		bool open;
+	} Slot;
+
+	deque<Slot> slots;
+	// freed slots, oldest first
+	deque<int> freeSlots;
+	unsigned long active;
+	// node id and epoch bits of every id, and the sequence number of the next
+	TransID prefix;
+	long long nextSequence;
+
+public:
+	PendingTable();
+	void setOwner(int node, int epoch);
+	transInfo *open();
+	transInfo *find(TransID id);
+	void close(transInfo *trans);
+	unsigned long size();
+	virtual ~PendingTable() {}
+};
+
+#endif /* PENDINGTABLE_H_ */
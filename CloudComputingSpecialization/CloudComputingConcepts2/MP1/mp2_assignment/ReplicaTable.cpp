@@ -0,0 +1,130 @@
+/**********************************
+ * FILE NAME: ReplicaTable.cpp
+ *
+ * DESCRIPTION: Definition of the precomputed token range to replica set table
+ **********************************/
+
+#include "ReplicaTable.h"
+
+/**
+ * FUNCTION NAME: sameReplicas
+ *
+ * DESCRIPTION: Returns true if both sets hold the same nodes in the same order
+ */
+bool sameReplicas(const ReplicaSet &a, const ReplicaSet &b) {
+	if ( a.count != b.count ) {
+		return false;
+	}
+	for ( int i = 0; i < a.count; i++ ) {
+		if ( memcmp(a.nodes[i].addr, b.nodes[i].addr, sizeof(a.nodes[i].addr)) != 0 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: isReplica
+ *
+ * DESCRIPTION: Returns true if addr is one of the nodes of set
+ */
+bool isReplica(const ReplicaSet &set, Address *addr) {
+	for ( int i = 0; i < set.count; i++ ) {
+		if ( memcmp(set.nodes[i].addr, addr->addr, sizeof(addr->addr)) == 0 ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: firstReplicas
+ *
+ * DESCRIPTION: Copy the first count nodes of set to first. first is left empty if
+ * 				set has fewer than count nodes.
+ */
+void firstReplicas(const ReplicaSet &set, int count, ReplicaSet &first) {
+	first.count = set.count < count ? 0 : min(count, MAX_REPLICAS);
+	for ( int i = 0; i < first.count; i++ ) {
+		first.nodes[i] = set.nodes[i];
+	}
+}
+
+/**
+ * Constructor
+ */
+ReplicaTable::ReplicaTable() {
+	none.count = 0;
+}
+
+/**
+ * FUNCTION NAME: build
+ *
+ * DESCRIPTION: Compute the replica set of every token of ring, which must be sorted.
+ * 				The range ending at a token is held by the node of that token and
+ * 				the next distinct nodes clockwise; further tokens of a node already
+ * 				chosen are skipped. With fewer than replicas distinct nodes every
+ * 				set holds all of them.
+ */
+void ReplicaTable::build(vector<Node> &ring, int replicas) {
+	size_t n = ring.size();
+
+	replicas = min(replicas, MAX_REPLICAS);
+	tokens.resize(n);
+	sets.resize(n);
+
+	for ( size_t i = 0; i < n; i++ ) {
+		ReplicaSet &set = sets[i];
+		tokens[i] = ring[i].getHashCode();
+		set.count = 0;
+
+		for ( size_t j = 0; j < n && set.count < replicas; j++ ) {
+			Address *addr = ring[(i + j) % n].getAddress();
+			if ( !isReplica(set, addr) ) {
+				set.nodes[set.count++] = *addr;
+			}
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: lookup
+ *
+ * DESCRIPTION: Returns the replica set of ring position pos: the one of the first
+ * 				token at or after pos, wrapping around past the last token
+ */
+const ReplicaSet &ReplicaTable::lookup(uint64_t pos) const {
+	if ( tokens.empty() ) {
+		return none;
+	}
+	return sets[rangeOf(pos)];
+}
+
+/**
+ * FUNCTION NAME: rangeOf
+ *
+ * DESCRIPTION: Returns the index of the range holding ring position pos. The
+ * 				table must not be empty.
+ */
+size_t ReplicaTable::rangeOf(uint64_t pos) const {
+	size_t i = lower_bound(tokens.begin(), tokens.end(), pos) - tokens.begin();
+	return i == tokens.size() ? 0 : i;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of tokens, i.e. of ranges
+ */
+size_t ReplicaTable::size() const {
+	return tokens.size();
+}
+
+/**
+ * FUNCTION NAME: token
+ *
+ * DESCRIPTION: Returns the i-th smallest token
+ */
+uint64_t ReplicaTable::token(size_t i) const {
+	return tokens[i];
+}
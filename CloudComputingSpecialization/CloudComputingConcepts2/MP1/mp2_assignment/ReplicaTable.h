@@ -0,0 +1,58 @@
+/**********************************
+ * FILE NAME: ReplicaTable.h
+ *
+ * DESCRIPTION: Header file of the precomputed token range to replica set table
+ **********************************/
+
+#ifndef REPLICATABLE_H_
+#define REPLICATABLE_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "Node.h"
+
+/*
+ * Macros
+ */
+// Most replicas a ReplicaSet holds
+#define MAX_REPLICAS 7
+
+/**
+ * STRUCT NAME: ReplicaSet
+ *
+ * DESCRIPTION: The distinct nodes holding a token range, in replica order
+ */
+typedef struct ReplicaSet {
+	int count;
+	Address nodes[MAX_REPLICAS];
+} ReplicaSet;
+
+bool sameReplicas(const ReplicaSet &a, const ReplicaSet &b);
+bool isReplica(const ReplicaSet &set, Address *addr);
+void firstReplicas(const ReplicaSet &set, int count, ReplicaSet &first);
+
+/**
+ * CLASS NAME: ReplicaTable
+ *
+ * DESCRIPTION: Sorted token positions of a ring and, per token, the replica set
+ * 				of the range ending at it. Built once per ring change for the
+ * 				largest replication factor; keys with a smaller one use the
+ * 				front of the set. A lookup is a binary search and allocates nothing.
+ */
+class ReplicaTable {
+private:
+	vector<uint64_t> tokens;
+	vector<ReplicaSet> sets;
+	ReplicaSet none;
+
+public:
+	ReplicaTable();
+	void build(vector<Node> &ring, int replicas);
+	const ReplicaSet &lookup(uint64_t pos) const;
+	size_t rangeOf(uint64_t pos) const;
+	size_t size() const;
+	uint64_t token(size_t i) const;
+	virtual ~ReplicaTable() {}
+};
+
+#endif /* REPLICATABLE_H_ */
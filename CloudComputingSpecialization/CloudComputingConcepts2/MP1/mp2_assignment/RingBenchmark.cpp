@@ -0,0 +1,204 @@
+/**********************************
+ * FILE NAME: RingBenchmark.cpp
+ *
+ * DESCRIPTION: Key placement benchmark of the MP2Node ring. Builds rings of
+ * 				various sizes and numbers of virtual nodes, places a set of
+ * 				keys with the ReplicaTable MP2Node uses and prints one JSON
+ * 				object per ring with the spread of the per node load and the
+ * 				cost of a replica lookup.
+ *
+ * 				Usage: ./RingBenchmark testcases/ringbench.conf > results.json
+ *
+ * 				The sweep file lists comma separated values:
+ * 					SIZES: 10,100
+ * 					VNODES: 1,8,32
+ * 					KEYS: 100000
+ * 				Any other line (WEIGHTS, ...) is passed on as an optional setting.
+ **********************************/
+
+#include "MP2Node.h"
+#include <chrono>
+
+#define ARGS_COUNT 2
+
+/**
+ * FUNCTION NAME: printStats
+ *
+ * DESCRIPTION: Print mean, standard deviation, coefficient of variation, min and max of counts
+ */
+static void printStats(const char *name, const vector<long> &counts) {
+	double mean = 0, var = 0;
+	long lo = counts.empty() ? 0 : counts[0], hi = lo;
+
+	for ( long count : counts ) {
+		mean += count;
+		lo = min(lo, count);
+		hi = max(hi, count);
+	}
+	mean /= max((size_t)1, counts.size());
+	for ( long count : counts ) {
+		var += (count - mean) * (count - mean);
+	}
+	var /= max((size_t)1, counts.size());
+
+	printf("\"%s\": {\"mean\": %.1f, \"stddev\": %.1f, \"cv\": %.4f, \"min\": %ld, \"max\": %ld, \"max_over_mean\": %.3f}",
+		   name, mean, sqrt(var), mean > 0 ? sqrt(var) / mean : 0.0, lo, hi, mean > 0 ? hi / mean : 0.0);
+}
+
+/**
+ * FUNCTION NAME: nodeAddress
+ *
+ * DESCRIPTION: Returns the Address Application gives the node with the given id
+ */
+static Address nodeAddress(int id) {
+	Address addr;
+	addr.init();
+	*(int *)(&addr.addr) = id;
+	*(short *)(&addr.addr[4]) = 0;
+	return addr;
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Place keys on a ring of n nodes and report the load of every node,
+ * 				and where the primary keys of node 1 go when it fails
+ */
+static void run(Params *par, int n, long keys) {
+	vector<Node> ring;
+	for ( int id = 1; id <= n; id++ ) {
+		Address addr = nodeAddress(id);
+		MP2Node::addTokens(ring, addr, par);
+	}
+	sort(ring.begin(), ring.end());
+
+	vector<Node> degraded;
+	for ( auto &node : ring ) {
+		if ( *(int *)(&node.getAddress()->addr) != 1 ) {
+			degraded.push_back(node);
+		}
+	}
+
+	auto start = chrono::steady_clock::now();
+	ReplicaTable table, degradedTable;
+	table.build(ring, NUM_REPLICAS);
+	double buildUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+	degradedTable.build(degraded, NUM_REPLICAS);
+
+	vector<uint64_t> positions(keys);
+	for ( long i = 0; i < keys; i++ ) {
+		positions[i] = MP2Node::hashFunction("key" + to_string(i));
+	}
+
+	// Time the lookups alone; the sum keeps them from being optimized away
+	long check = 0;
+	start = chrono::steady_clock::now();
+	for ( long i = 0; i < keys; i++ ) {
+		check += table.lookup(positions[i]).count;
+	}
+	double lookupNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / max(1L, keys);
+
+	vector<long> load(n, 0), primary(n, 0), takeover(n, 0);
+	long orphans = 0;
+
+	for ( long i = 0; i < keys; i++ ) {
+		const ReplicaSet &replicas = table.lookup(positions[i]);
+		for ( int r = 0; r < replicas.count; r++ ) {
+			int id = *(int *)(&replicas.nodes[r].addr);
+			load[id - 1]++;
+			if ( r == 0 ) {
+				primary[id - 1]++;
+			}
+		}
+
+		if ( replicas.count > 0 && *(int *)(&replicas.nodes[0].addr) == 1 ) {
+			const ReplicaSet &heirs = degradedTable.lookup(positions[i]);
+			if ( heirs.count > 0 ) {
+				takeover[*(int *)(&heirs.nodes[0].addr) - 1]++;
+				orphans++;
+			}
+		}
+	}
+
+	printf("{\"nodes\": %d, \"vnodes\": %d, \"tokens\": %d, \"keys\": %ld, ", n, par->VNODES, (int)ring.size(), keys);
+	printStats("replica_load", load);
+	printf(", ");
+	printStats("primary_load", primary);
+	printf(", \"failover_max_share\": %.3f, \"build_us\": %.1f, \"lookup_ns\": %.1f}",
+		   orphans ? (double)*max_element(takeover.begin(), takeover.end()) / orphans : 0.0,
+		   buildUs, check > 0 ? lookupNs : 0.0);
+}
+
+/**
+ * FUNCTION NAME: splitList
+ *
+ * DESCRIPTION: Split a comma separated list of integers
+ */
+static vector<long> splitList(char *value) {
+	vector<long> items;
+	for ( char *item = strtok(value, ","); item; item = strtok(NULL, ",") ) {
+		items.push_back(atol(item));
+	}
+	return items;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Run every combination of the sweep and print a JSON array to stdout
+ **********************************/
+int main(int argc, char *argv[]) {
+	if ( argc != ARGS_COUNT ) {
+		cerr<<"Sweep configuration (i.e., ringbench.conf) file required"<<endl;
+		return FAILURE;
+	}
+
+	FILE *fp = fopen(argv[1], "r");
+	if ( !fp ) {
+		cerr<<"Cannot open "<<argv[1]<<endl;
+		return FAILURE;
+	}
+
+	Params *par = new Params();
+	par->VNODES = 1;
+	par->HASH_SEED = 0;
+	par->ORDERED_PARTITIONER = 0;
+	vector<long> sizes(1, 10);
+	vector<long> vnodes(1, 1);
+	long keys = 100000;
+	char name[64];
+	char value[256];
+
+	while ( fscanf(fp, " %63[^:]: %255s", name, value) == 2 ) {
+		if ( 0 == strcmp(name, "SIZES") ) {
+			sizes = splitList(value);
+		}
+		else if ( 0 == strcmp(name, "VNODES") ) {
+			vnodes = splitList(value);
+		}
+		else if ( 0 == strcmp(name, "KEYS") ) {
+			keys = atol(value);
+		}
+		else {
+			par->setoption(name, value);
+		}
+	}
+	fclose(fp);
+	setRingHashSeed(par->HASH_SEED);
+	setRingOrdered(par->ORDERED_PARTITIONER);
+
+	printf("[");
+	bool first = true;
+	for ( long n : sizes ) {
+		for ( long v : vnodes ) {
+			par->VNODES = max(1L, v);
+			printf("%s\n", first ? "" : ",");
+			run(par, (int)n, keys);
+			first = false;
+		}
+	}
+	printf("\n]\n");
+
+	delete par;
+	return SUCCESS;
+}
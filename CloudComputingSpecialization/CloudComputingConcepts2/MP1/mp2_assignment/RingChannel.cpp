@@ -0,0 +1,329 @@
+/**********************************
+ * FILE NAME: RingChannel.cpp
+ *
+ * DESCRIPTION: Definition of the ring dissemination channel
+ **********************************/
+
+#include "RingChannel.h"
+
+/**
+ * Constructor
+ */
+RingChannel::RingChannel(Member *memberNode, Overlay *overlay, EmulNet *emulNet, Params *params, Log *log) {
+	this->memberNode = memberNode;
+	this->overlay = overlay;
+	this->emulNet = emulNet;
+	this->par = params;
+	this->log = log;
+	this->selfId = overlayId(&memberNode->addr);
+	this->syncCursor = 0;
+	this->syncNeighbor = 0;
+
+	RingEntry me;
+	me.incarnation = 0;
+	me.status = RING_ALIVE;
+	table[selfId] = me;
+}
+
+/**
+ * FUNCTION NAME: addMember
+ *
+ * DESCRIPTION: A member came alive: log it and add it to memberList
+ */
+void RingChannel::addMember(int id) {
+	Address addr = overlayAddress(id);
+	log->logNodeAdd(&memberNode->addr, &addr);
+
+	MemberListEntry me(id, 0, 0, par->getcurrtime());
+	memberNode->memberList.emplace_back(me);
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: A member failed or left: log it and remove it from memberList
+ */
+void RingChannel::removeMember(int id) {
+	Address addr = overlayAddress(id);
+	log->logNodeRemove(&memberNode->addr, &addr);
+
+	for ( auto it = memberNode->memberList.begin(); it != memberNode->memberList.end(); ++it ) {
+		if ( it->id == id ) {
+			memberNode->memberList.erase(it);
+			break;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: apply
+ *
+ * DESCRIPTION: Merge an entry into the table and queue it for flooding if it was news
+ *
+ * RETURNS:
+ * true if the table changed
+ */
+bool RingChannel::apply(int id, RingEntry entry, int from) {
+	RingEvent event;
+
+	if ( id == selfId ) {
+		RingEntry &mine = table[selfId];
+		if ( mine.status != RING_ALIVE || entry.status == RING_ALIVE || entry.incarnation < mine.incarnation ) {
+			return false;
+		}
+		// Someone thinks I am gone: refute it with a fresh incarnation
+		mine.incarnation = entry.incarnation + 1;
+		event.id = selfId;
+		event.entry = mine;
+		event.from = -1;
+		outbox[selfId] = event;
+		return true;
+	}
+
+	auto it = table.find(id);
+	if ( it == table.end() ) {
+		table[id] = entry;
+		if ( entry.status == RING_ALIVE ) {
+			addMember(id);
+		}
+	}
+	else {
+		RingEntry &current = it->second;
+		if ( entry.incarnation < current.incarnation ||
+			 (entry.incarnation == current.incarnation && entry.status <= current.status) ) {
+			return false;
+		}
+
+		bool wasAlive = current.status == RING_ALIVE;
+		current = entry;
+		if ( wasAlive && entry.status != RING_ALIVE ) {
+			removeMember(id);
+		}
+		else if ( !wasAlive && entry.status == RING_ALIVE ) {
+			addMember(id);
+		}
+	}
+
+	event.id = id;
+	event.entry = entry;
+	event.from = from;
+	outbox[id] = event;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Append one entry to a message payload as varint(id), varint(incarnation), status
+ */
+void RingChannel::encode(int id, const RingEntry &entry, vector<unsigned char> &buf) {
+	MemberListCodec::putVarint(buf, (unsigned int)id);
+	MemberListCodec::putVarint(buf, (unsigned int)entry.incarnation);
+	buf.push_back(entry.status);
+}
+
+/**
+ * FUNCTION NAME: encodeTable
+ *
+ * DESCRIPTION: Encode up to count table entries starting at it, split into
+ * 				payloads that each fit in one RINGSYNC message
+ *
+ * RETURNS:
+ * iterator to the first entry not encoded
+ */
+map<int, RingChannel::RingEntry>::iterator RingChannel::encodeTable(map<int, RingEntry>::iterator it, unsigned int count, vector<vector<unsigned char> > &chunks) {
+	size_t limit = par->MAX_MSG_SIZE - VIEWMSGHDR_SIZE - RING_MSG_SLACK;
+
+	chunks.push_back(vector<unsigned char>());
+	for ( ; it != table.end() && count > 0; ++it, --count ) {
+		if ( chunks.back().size() >= limit ) {
+			chunks.push_back(vector<unsigned char>());
+		}
+		encode(it->first, it->second, chunks.back());
+	}
+
+	return it;
+}
+
+/**
+ * FUNCTION NAME: answerJoins
+ *
+ * DESCRIPTION: Send one snapshot of the table to the nodes that joined through
+ * 				this one, at most JOIN_BATCH of them per tick
+ */
+void RingChannel::answerJoins() {
+	if ( joiners.empty() ) {
+		return;
+	}
+
+	size_t count = joiners.size();
+	if ( par->JOIN_BATCH > 0 ) {
+		count = min(count, (size_t)par->JOIN_BATCH);
+	}
+
+	vector<vector<unsigned char> > chunks;
+	encodeTable(table.begin(), (unsigned int)table.size(), chunks);
+	for ( size_t i = 0; i < count; i++ ) {
+		for ( auto &chunk : chunks ) {
+			sendViewMessage(emulNet, &memberNode->addr, joiners[i], RINGSYNC, selfId, 0, 0, chunk);
+		}
+	}
+	joiners.erase(joiners.begin(), joiners.begin() + count);
+}
+
+/**
+ * FUNCTION NAME: onNeighborUp
+ *
+ * DESCRIPTION: Having a neighbor means this node is connected to the group
+ */
+void RingChannel::onNeighborUp(int id) {
+	memberNode->inGroup = true;
+}
+
+/**
+ * FUNCTION NAME: onNeighborDown
+ *
+ * DESCRIPTION: A neighbor that stopped answering is declared failed at its current incarnation
+ */
+void RingChannel::onNeighborDown(int id, bool failed) {
+	if ( !failed ) {
+		return;
+	}
+
+	RingEntry entry;
+	auto it = table.find(id);
+	entry.incarnation = it != table.end() ? it->second.incarnation : 0;
+	entry.status = RING_FAILED;
+	apply(id, entry, -1);
+}
+
+/**
+ * FUNCTION NAME: onJoinRequest
+ *
+ * DESCRIPTION: Announce the joining node and hand it a snapshot of the ring
+ */
+void RingChannel::onJoinRequest(int id) {
+	RingEntry entry;
+	entry.incarnation = 0;
+	entry.status = RING_ALIVE;
+	apply(id, entry, id);
+
+	if ( find(joiners.begin(), joiners.end(), id) == joiners.end() ) {
+		joiners.push_back(id);
+	}
+}
+
+/**
+ * FUNCTION NAME: recv
+ *
+ * DESCRIPTION: Message handler for RINGEVENT and RINGSYNC
+ *
+ * RETURNS:
+ * false if the message is not a ring message
+ */
+bool RingChannel::recv(char *data, int size) {
+	ViewMsgHdr *msg = parseViewMessage(data, size);
+	if ( !msg || (msg->msgType != RINGEVENT && msg->msgType != RINGSYNC) ) {
+		return false;
+	}
+
+	int from = overlayId(&msg->fromAddr);
+	const unsigned char *pos = msg->ml;
+	const unsigned char *end = msg->ml + msg->size;
+	unsigned int id, incarnation;
+
+	while ( pos < end ) {
+		if ( !MemberListCodec::getVarint(pos, end, id) ||
+			 !MemberListCodec::getVarint(pos, end, incarnation) ||
+			 pos >= end || *pos > RING_LEFT ) {
+			break;
+		}
+
+		RingEntry entry;
+		entry.incarnation = (int)incarnation;
+		entry.status = *pos++;
+		apply((int)id, entry, from);
+	}
+
+	return true;
+}
+
+/**
+ * FUNCTION NAME: flood
+ *
+ * DESCRIPTION: Send the changes collected so far to the given neighbors
+ */
+void RingChannel::flood(const vector<int> &peers) {
+	if ( outbox.empty() ) {
+		return;
+	}
+
+	size_t limit = par->MAX_MSG_SIZE - VIEWMSGHDR_SIZE - RING_MSG_SLACK;
+
+	for ( int peer : peers ) {
+		vector<unsigned char> payload;
+		for ( auto &entry : outbox ) {
+			if ( entry.second.from == peer ) {
+				continue;
+			}
+			encode(entry.first, entry.second.entry, payload);
+			if ( payload.size() >= limit ) {
+				sendViewMessage(emulNet, &memberNode->addr, peer, RINGEVENT, selfId, 0, 0, payload);
+				payload.clear();
+			}
+		}
+		if ( !payload.empty() ) {
+			sendViewMessage(emulNet, &memberNode->addr, peer, RINGEVENT, selfId, 0, 0, payload);
+		}
+	}
+	outbox.clear();
+}
+
+/**
+ * FUNCTION NAME: leave
+ *
+ * DESCRIPTION: Announce that this node leaves the ring. The event goes out now,
+ * 				together with anything not flooded yet, since there is no next tick.
+ */
+void RingChannel::leave() {
+	RingEvent event;
+	RingEntry &mine = table[selfId];
+
+	mine.status = RING_LEFT;
+	event.id = selfId;
+	event.entry = mine;
+	event.from = -1;
+	outbox[selfId] = event;
+
+	vector<int> peers;
+	overlay->neighbors(peers);
+	flood(peers);
+}
+
+/**
+ * FUNCTION NAME: tick
+ *
+ * DESCRIPTION: Flood the changes collected since the last tick and run a round of anti-entropy
+ */
+void RingChannel::tick() {
+	vector<int> peers;
+	overlay->neighbors(peers);
+
+	answerJoins();
+	flood(peers);
+
+	if ( par->RING_SYNC_PERIOD > 0 && !peers.empty() &&
+		 (par->getcurrtime() + selfId) % par->RING_SYNC_PERIOD == 0 ) {
+		int to = peers[syncNeighbor++ % peers.size()];
+		auto it = table.lower_bound(syncCursor);
+		if ( it == table.end() ) {
+			it = table.begin();
+		}
+		vector<vector<unsigned char> > chunks;
+		it = encodeTable(it, RING_SYNC_BATCH, chunks);
+		syncCursor = it != table.end() ? it->first : 0;
+		for ( auto &chunk : chunks ) {
+			sendViewMessage(emulNet, &memberNode->addr, to, RINGSYNC, selfId, 0, 0, chunk);
+		}
+	}
+}
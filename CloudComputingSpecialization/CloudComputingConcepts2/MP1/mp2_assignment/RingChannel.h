@@ -0,0 +1,98 @@
+/**********************************
+ * FILE NAME: RingChannel.h
+ *
+ * DESCRIPTION: Header file of the ring dissemination channel
+ **********************************/
+
+#ifndef _RINGCHANNEL_H_
+#define _RINGCHANNEL_H_
+
+#include "stdincludes.h"
+#include "Log.h"
+#include "Params.h"
+#include "Member.h"
+#include "EmulNet.h"
+#include "Overlay.h"
+#include "MemberListCodec.h"
+
+/*
+ * Macros
+ */
+// Room left in a message for the EmulNet envelope
+#define RING_MSG_SLACK 64
+// Number of ring entries pushed to one neighbor per anti-entropy round
+#define RING_SYNC_BATCH 64
+
+/**
+ * Ring member status, in order of precedence at equal incarnation
+ */
+enum RingStatus {
+	RING_ALIVE,
+	RING_FAILED,
+	RING_LEFT
+};
+
+/**
+ * CLASS NAME: RingChannel
+ *
+ * DESCRIPTION: Spreads ring membership changes (join, failure, leave) over the
+ * 				overlay instead of every node probing every other node.
+ * 				Each entry carries an incarnation number that only its owner
+ * 				increments: a higher incarnation always wins, and at equal
+ * 				incarnation LEFT beats FAILED beats ALIVE. A node that hears it
+ * 				was declared failed refutes it by bumping its incarnation.
+ * 				Changes are flooded to the active neighbors once per tick and a
+ * 				slice of the table is pushed to one neighbor every
+ * 				RING_SYNC_PERIOD ticks to repair lost floods. Nodes that
+ * 				joined through this one during a tick share one snapshot.
+ * 				Live entries are mirrored in Member::memberList, which is all
+ * 				MP2Node needs to build its ring.
+ */
+class RingChannel: public OverlayListener {
+private:
+	typedef struct RingEntry {
+		int incarnation;
+		unsigned char status;
+	} RingEntry;
+
+	typedef struct RingEvent {
+		int id;
+		RingEntry entry;
+		// neighbor the event was learned from, which does not need it back
+		int from;
+	} RingEvent;
+
+	Member *memberNode;
+	Overlay *overlay;
+	EmulNet *emulNet;
+	Params *par;
+	Log *log;
+	int selfId;
+	map<int, RingEntry> table;
+	// changes to flood on the next tick : key-node id
+	map<int, RingEvent> outbox;
+	// joiners waiting for a snapshot of the table
+	vector<int> joiners;
+	int syncCursor;
+	unsigned int syncNeighbor;
+
+	bool apply(int id, RingEntry entry, int from);
+	void addMember(int id);
+	void removeMember(int id);
+	void encode(int id, const RingEntry &entry, vector<unsigned char> &buf);
+	map<int, RingEntry>::iterator encodeTable(map<int, RingEntry>::iterator it, unsigned int count, vector<vector<unsigned char> > &chunks);
+	void answerJoins();
+	void flood(const vector<int> &peers);
+
+public:
+	RingChannel(Member *memberNode, Overlay *overlay, EmulNet *emulNet, Params *params, Log *log);
+	void onNeighborUp(int id);
+	void onNeighborDown(int id, bool failed);
+	void onJoinRequest(int id);
+	bool recv(char *data, int size);
+	void tick();
+	void leave();
+	virtual ~RingChannel() {}
+};
+
+#endif /* _RINGCHANNEL_H_ */
@@ -0,0 +1,139 @@
+/**********************************
+ * FILE NAME: RingHash.cpp
+ *
+ * DESCRIPTION: 64-bit ring hash (MurmurHash64A, Austin Appleby, public domain).
+ * 				Input words are read as little endian, so every build and
+ * 				platform places nodes and keys at the same ring positions.
+ **********************************/
+
+#include "RingHash.h"
+
+static uint64_t ringHashSeed = 0;
+static bool ringIsOrdered = false;
+
+/**
+ * FUNCTION NAME: setRingHashSeed
+ *
+ * DESCRIPTION: Set the seed of ringHash. All nodes must use the same seed.
+ */
+void setRingHashSeed(uint64_t seed) {
+	ringHashSeed = seed;
+}
+
+/**
+ * FUNCTION NAME: ringHash
+ *
+ * DESCRIPTION: Hash len bytes of data to a position on the ring
+ */
+uint64_t ringHash(const void *data, size_t len) {
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	const unsigned char *p = (const unsigned char *)data;
+	const unsigned char *end = p + (len & ~(size_t)7);
+	uint64_t h = ringHashSeed ^ (len * m);
+
+	for ( ; p != end; p += 8 ) {
+		uint64_t k = 0;
+		for ( int i = 7; i >= 0; i-- ) {
+			k = (k << 8) | p[i];
+		}
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
+	}
+
+	switch ( len & 7 ) {
+		case 7: h ^= uint64_t(p[6]) << 48;
+		case 6: h ^= uint64_t(p[5]) << 40;
+		case 5: h ^= uint64_t(p[4]) << 32;
+		case 4: h ^= uint64_t(p[3]) << 24;
+		case 3: h ^= uint64_t(p[2]) << 16;
+		case 2: h ^= uint64_t(p[1]) << 8;
+		case 1: h ^= uint64_t(p[0]);
+				h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
+}
+
+/**
+ * FUNCTION NAME: ringHash
+ *
+ * DESCRIPTION: Hash a key to a position on the ring
+ */
+uint64_t ringHash(const string &key) {
+	return ringHash(key.data(), key.size());
+}
+
+/**
+ * FUNCTION NAME: setRingOrdered
+ *
+ * DESCRIPTION: Place keys on the ring in key order (orderedPosition) rather than
+ * 				by ringHash. All nodes must agree.
+ */
+void setRingOrdered(bool ordered) {
+	ringIsOrdered = ordered;
+}
+
+/**
+ * FUNCTION NAME: ringOrdered
+ *
+ * RETURNS:
+ * true if keys are placed on the ring in key order
+ */
+bool ringOrdered() {
+	return ringIsOrdered;
+}
+
+/**
+ * FUNCTION NAME: orderedPosition
+ *
+ * DESCRIPTION: Position of a key on the ring that keeps key order: the first
+ * 				nine characters read as digits of base 95, the printable ASCII
+ * 				characters in order with the bytes below and above them taken
+ * 				as the first and last, then scaled to the whole ring. A key
+ * 				never comes before a smaller one, so the keys of a token range
+ * 				are one interval of keys, and printable keys spread over the
+ * 				ring rather than a band of it.
+ */
+uint64_t orderedPosition(const string &key) {
+	uint64_t pos = 0;
+
+	for ( size_t i = 0; i < 9; i++ ) {
+		int digit = 0;
+		if ( i < key.size() ) {
+			digit = min(max((int)(unsigned char)key[i] - ' ', 0), 94);
+		}
+		pos = pos * 95 + digit;
+	}
+
+	// 95^9 * 29 < 2^64
+	return pos * 29;
+}
+
+/**
+ * FUNCTION NAME: orderedToken
+ *
+ * DESCRIPTION: Token of the index-th virtual node when keys are in key order: the
+ * 				index-th point of the van der Corput sequence, its bits reversed.
+ * 				The points of a run of indices split the ring evenly, each new
+ * 				one halving one of the widest ranges left, so a node that joins
+ * 				splits ranges in two and one that leaves merges its ranges into
+ * 				the next, and no other boundary moves.
+ */
+uint64_t orderedToken(uint64_t index) {
+	uint64_t token = 0;
+
+	for ( int i = 0; i < 64; i++ ) {
+		token = (token << 1) | ((index >> i) & 1);
+	}
+	return token;
+}
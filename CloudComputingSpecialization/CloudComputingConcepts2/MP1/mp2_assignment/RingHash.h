@@ -0,0 +1,21 @@
+/**********************************
+ * FILE NAME: RingHash.h
+ *
+ * DESCRIPTION: Header file of the hash function placing nodes and keys on the ring
+ **********************************/
+
+#ifndef _RINGHASH_H_
+#define _RINGHASH_H_
+
+#include "stdincludes.h"
+#include <stdint.h>
+
+void setRingHashSeed(uint64_t seed);
+uint64_t ringHash(const void *data, size_t len);
+uint64_t ringHash(const string &key);
+void setRingOrdered(bool ordered);
+bool ringOrdered();
+uint64_t orderedPosition(const string &key);
+uint64_t orderedToken(uint64_t index);
+
+#endif /* _RINGHASH_H_ */
@@ -0,0 +1,302 @@
+/**********************************
+ * FILE NAME: StoreTest.cpp
+ *
+ * DESCRIPTION: Checks of the key-value store that the CRUD tests do not reach.
+ * 				A check runs a part of the store alone, or a group of MP1Node
+ * 				and MP2Node pairs on the emulated network, stepped the way
+ * 				Application steps them, and prints ok or FAIL; the exit
+ * 				status is FAILURE if any check failed.
+ *
+ * 				Usage: ./StoreTest testcases/create.conf    (or make check)
+ *
+ * 				The test case file gives the group size and the defaults,
+ * 				each check sets the optional settings it needs on top.
+ **********************************/
+
+#include "MP1Node.h"
+#include "MP2Node.h"
+
+#define ARGS_COUNT 2
+// ticks the nodes get to join before the store is used
+#define JOIN_TIME 100
+
+/**
+ * CLASS NAME: TestRing
+ *
+ * DESCRIPTION: The nodes of one check and the networks between them
+ */
+class TestRing {
+public:
+	Params *par;
+	Log *log;
+	EmulNet *en;
+	EmulNet *en1;
+	vector<MP1Node *> mp1;
+	vector<MP2Node *> mp2;
+
+	TestRing(char *conf, const vector<pair<string, string> > &options);
+	void tick();
+	void run(int ticks);
+	MP2Node *node(Address &addr);
+	~TestRing();
+};
+
+/**
+ * Constructor: the nodes of the test case, with the given optional settings
+ */
+TestRing::TestRing(char *conf, const vector<pair<string, string> > &options) {
+	par = new Params();
+	par->setparams(conf);
+	for ( auto &option : options ) {
+		char name[64];
+		char value[64];
+		snprintf(name, sizeof(name), "%s", option.first.c_str());
+		snprintf(value, sizeof(value), "%s", option.second.c_str());
+		par->setoption(name, value);
+	}
+	log = new Log(par);
+	en = new EmulNet(par);
+	en1 = new EmulNet(par);
+
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		Member *memberNode = new Member;
+		memberNode->inited = false;
+		Address addressOfMemberNode;
+		en->ENinit(&addressOfMemberNode, par->PORTNUM);
+		mp1.push_back(new MP1Node(memberNode, par, en, log, &addressOfMemberNode));
+		mp2.push_back(new MP2Node(memberNode, par, en1, log, &addressOfMemberNode));
+	}
+}
+
+/**
+ * Destructor
+ */
+TestRing::~TestRing() {
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		delete mp1[i];
+		delete mp2[i];
+	}
+	en->ENcleanup();
+	en1->ENcleanup();
+	delete en;
+	delete en1;
+	delete log;
+	delete par;
+}
+
+/**
+ * FUNCTION NAME: tick
+ *
+ * DESCRIPTION: One time step of every node: membership first, then, once the
+ * 				nodes had JOIN_TIME to join, the store
+ */
+void TestRing::tick() {
+	char joinaddr[30] = "";
+	int i;
+
+	for ( i = 0; i < par->EN_GPSZ; i++ ) {
+		if ( par->getcurrtime() > (int)(par->STEP_RATE*i) && !mp1[i]->getMemberNode()->bFailed ) {
+			mp1[i]->recvLoop();
+		}
+	}
+	for ( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
+		if ( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+			mp1[i]->nodeStart(joinaddr, par->PORTNUM);
+		}
+		else if ( par->getcurrtime() > (int)(par->STEP_RATE*i) && !mp1[i]->getMemberNode()->bFailed ) {
+			mp1[i]->nodeLoop();
+		}
+	}
+
+	if ( par->getcurrtime() >= JOIN_TIME ) {
+		for ( i = 0; i < par->EN_GPSZ; i++ ) {
+			if ( !mp2[i]->getMemberNode()->bFailed ) {
+				if ( mp2[i]->getMemberNode()->inited && mp2[i]->getMemberNode()->inGroup ) {
+					mp2[i]->updateRing();
+				}
+				mp2[i]->recvLoop();
+			}
+		}
+		for ( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
+			if ( !mp2[i]->getMemberNode()->bFailed ) {
+				mp2[i]->checkMessages();
+			}
+		}
+	}
+	par->globaltime++;
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Step the nodes the given number of ticks
+ */
+void TestRing::run(int ticks) {
+	for ( int i = 0; i < ticks; i++ ) {
+		tick();
+	}
+}
+
+/**
+ * FUNCTION NAME: node
+ *
+ * DESCRIPTION: Returns the store of the node at addr
+ */
+MP2Node *TestRing::node(Address &addr) {
+	return mp2[*(int *)(&addr.addr) - 1];
+}
+
+/**
+ * FUNCTION NAME: pendingIds
+ *
+ * DESCRIPTION: Open and close more transactions in a row than a slot could tell
+ * 				apart by a generation of its own, one at a time and a few at a
+ * 				time, and check that no id comes back and no closed one is found
+ */
+static bool pendingIds(char *conf) {
+	PendingTable table;
+	set<TransID> seen;
+	vector<TransID> closed;
+
+	table.setOwner(7, 42);
+	for ( int i = 0; i < 3 * PENDING_SLOTS / 2 + 5000; i++ ) {
+		int open = i < 5000 ? 1 : 1 + i % 4;
+		vector<transInfo *> batch;
+
+		for ( int j = 0; j < open; j++ ) {
+			transInfo *trans = table.open();
+			if ( !trans || !seen.insert(trans->id).second || table.find(trans->id) != trans ) {
+				return false;
+			}
+			batch.push_back(trans);
+		}
+		for ( transInfo *trans : batch ) {
+			closed.push_back(trans->id);
+			table.close(trans);
+		}
+	}
+
+	for ( TransID id : closed ) {
+		if ( table.find(id) ) {
+			return false;
+		}
+	}
+	return table.size() == 0;
+}
+
+/**
+ * FUNCTION NAME: treeRepair
+ *
+ * DESCRIPTION: Give one replica a newer version of every key it holds, so every
+ * 				leaf of its trees differs from its peers, and check that
+ * 				anti-entropy brings all the replicas to it
+ */
+static bool treeRepair(char *conf) {
+	TestRing ring(conf, {{"ANTI_ENTROPY_PERIOD", "5"}});
+	vector<pair<string, string> > pairs;
+
+	for ( int i = 0; i < 4000; i++ ) {
+		char key[16];
+		snprintf(key, sizeof(key), "tree%05d", i);
+		pairs.push_back(make_pair(string(key), string("old")));
+	}
+	ring.run(JOIN_TIME + 10);
+	OpHandle load = ring.mp2[0]->bulkLoad(pairs);
+	ring.run(10);
+	if ( !load->success ) {
+		return false;
+	}
+
+	MP2Node *diverged = ring.mp2[1];
+	vector<string> keys;
+	for ( auto &kv : pairs ) {
+		vector<Node> replicas = diverged->findNodes(kv.first);
+		for ( size_t index = 0; index < replicas.size(); index++ ) {
+			int version;
+			if ( *replicas[index].getAddress() == diverged->getMemberNode()->addr &&
+				 diverged->readKey(kv.first, version) == "old" ) {
+				diverged->applyVersion(kv.first, "new", version + 1, false, diverged->GetReplicaType(index), 0);
+				keys.push_back(kv.first);
+			}
+		}
+	}
+	ring.run(100);
+
+	for ( auto &key : keys ) {
+		for ( auto &replica : diverged->findNodes(key) ) {
+			if ( ring.node(*replica.getAddress())->readKey(key) != "new" ) {
+				return false;
+			}
+		}
+	}
+	return !keys.empty();
+}
+
+/**
+ * FUNCTION NAME: loadVersions
+ *
+ * DESCRIPTION: Load keys over a newer write and a newer delete of some of them,
+ * 				and check that the load takes only the keys it is newer for
+ */
+static bool loadVersions(char *conf) {
+	TestRing ring(conf, {{"ANTI_ENTROPY_PERIOD", "1000"}});
+	vector<pair<string, string> > pairs = {
+		{"load-deleted", "old"}, {"load-plain", "old"}, {"load-written", "old"}};
+
+	ring.run(JOIN_TIME + 10);
+	OpHandle first = ring.mp2[0]->bulkLoad(pairs);
+	ring.run(10);
+
+	int later = ring.par->getcurrtime() + 1000;
+	for ( auto &replica : ring.mp2[0]->findNodes("load-written") ) {
+		ring.node(*replica.getAddress())->applyVersion("load-written", "newer", later, false, PRIMARY, 0);
+	}
+	for ( auto &replica : ring.mp2[0]->findNodes("load-deleted") ) {
+		ring.node(*replica.getAddress())->applyVersion("load-deleted", "", later, true, PRIMARY, 0);
+	}
+	for ( auto &kv : pairs ) {
+		kv.second = "new";
+	}
+	OpHandle second = ring.mp2[0]->bulkLoad(pairs);
+	ring.run(10);
+	if ( !first->success || !second->success ) {
+		return false;
+	}
+
+	for ( auto &kv : pairs ) {
+		string expected = kv.first == "load-written" ? "newer" : kv.first == "load-deleted" ? "" : "new";
+		for ( auto &replica : ring.mp2[0]->findNodes(kv.first) ) {
+			if ( ring.node(*replica.getAddress())->readKey(kv.first) != expected ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Run every check and print its outcome
+ **********************************/
+int main(int argc, char *argv[]) {
+	if ( argc != ARGS_COUNT ) {
+		cerr<<"Configuration (i.e., *.conf) file required"<<endl;
+		return FAILURE;
+	}
+
+	vector<pair<const char *, bool (*)(char *)> > checks = {
+		{"pending_ids", pendingIds},
+		{"tree_repair", treeRepair},
+		{"load_versions", loadVersions},
+	};
+	int failed = 0;
+
+	for ( auto &check : checks ) {
+		bool ok = check.second(argv[1]);
+		printf("%s: %s\n", check.first, ok ? "ok" : "FAIL");
+		failed += ok ? 0 : 1;
+	}
+
+	return failed ? FAILURE : SUCCESS;
+}
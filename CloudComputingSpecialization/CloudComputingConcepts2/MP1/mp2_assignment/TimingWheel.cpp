@@ -0,0 +1,208 @@
+/**********************************
+ * FILE NAME: TimingWheel.cpp
+ *
+ * DESCRIPTION: Definition of the hierarchical timing wheel
+ **********************************/
+
+#include "TimingWheel.h"
+
+/**
+ * Constructor
+ */
+TimingWheel::TimingWheel(int now): current(now), active(0) {
+	for ( int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++ ) {
+		heads[i] = -1;
+	}
+}
+
+/**
+ * FUNCTION NAME: slotFor
+ *
+ * DESCRIPTION: Returns the wheel slot a deadline belongs to, relative to the current tick
+ */
+int TimingWheel::slotFor(int deadline) {
+	long delta = (long)deadline - current;
+
+	if ( delta <= 0 ) {
+		// Only reached while cascading, right before the current slot is expired
+		return current & (WHEEL_SLOTS - 1);
+	}
+
+	for ( int level = 0; level < WHEEL_LEVELS; level++ ) {
+		if ( delta < (1L << (WHEEL_BITS * (level + 1))) ) {
+			return level * WHEEL_SLOTS + ((deadline >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+		}
+	}
+
+	// Beyond the range of the outermost wheel: park it in the last slot that is in range
+	int parked = current + (int)((1L << (WHEEL_BITS * WHEEL_LEVELS)) - 1);
+	return (WHEEL_LEVELS - 1) * WHEEL_SLOTS + ((parked >> (WHEEL_BITS * (WHEEL_LEVELS - 1))) & (WHEEL_SLOTS - 1));
+}
+
+/**
+ * FUNCTION NAME: link
+ *
+ * DESCRIPTION: Insert a timer at the head of its slot list
+ */
+void TimingWheel::link(int index) {
+	Timer &t = timers[index];
+	t.slot = slotFor(t.deadline);
+	t.prev = -1;
+	t.next = heads[t.slot];
+	if ( t.next != -1 ) {
+		timers[t.next].prev = index;
+	}
+	heads[t.slot] = index;
+}
+
+/**
+ * FUNCTION NAME: unlink
+ *
+ * DESCRIPTION: Remove a timer from its slot list
+ */
+void TimingWheel::unlink(int index) {
+	Timer &t = timers[index];
+	if ( t.prev != -1 ) {
+		timers[t.prev].next = t.next;
+	}
+	else {
+		heads[t.slot] = t.next;
+	}
+	if ( t.next != -1 ) {
+		timers[t.next].prev = t.prev;
+	}
+	t.slot = -1;
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Arm a timer that fires once the wheel reaches deadline
+ *
+ * RETURNS:
+ * id of the timer, to be used with cancel
+ */
+TimingWheel::TimerId TimingWheel::schedule(int deadline, long key) {
+	int index;
+
+	if ( !freeTimers.empty() ) {
+		index = freeTimers.back();
+		freeTimers.pop_back();
+	}
+	else {
+		index = (int)timers.size();
+		Timer t;
+		t.generation = 0;
+		timers.push_back(t);
+	}
+
+	Timer &t = timers[index];
+	// The current tick has already been expired; overdue timers fire on the next one
+	t.deadline = max(deadline, current + 1);
+	t.key = key;
+	t.generation++;
+	link(index);
+	active++;
+
+	return ((TimerId)t.generation << 32) | (TimerId)(index + 1);
+}
+
+/**
+ * FUNCTION NAME: cancel
+ *
+ * DESCRIPTION: Disarm a timer
+ *
+ * RETURNS:
+ * true if the timer was pending
+ * false if it already fired, was already cancelled or the id is invalid
+ */
+bool TimingWheel::cancel(TimerId id) {
+	long index = (long)(id & 0xffffffffUL) - 1;
+	unsigned int generation = (unsigned int)(id >> 32);
+
+	if ( index < 0 || index >= (long)timers.size() ) {
+		return false;
+	}
+	Timer &t = timers[index];
+	if ( t.generation != generation || t.slot == -1 ) {
+		return false;
+	}
+
+	unlink((int)index);
+	freeTimers.push_back((int)index);
+	active--;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: cascade
+ *
+ * DESCRIPTION: Redistribute the timers of the current slot of an outer wheel into the inner wheels
+ */
+void TimingWheel::cascade(int level) {
+	int slot = level * WHEEL_SLOTS + ((current >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+	int index = heads[slot];
+
+	heads[slot] = -1;
+	while ( index != -1 ) {
+		int next = timers[index].next;
+		link(index);
+		index = next;
+	}
+}
+
+/**
+ * FUNCTION NAME: advance
+ *
+ * DESCRIPTION: Move the wheel forward to now and append the keys of the timers that fired
+ */
+void TimingWheel::advance(int now, vector<long> &expired) {
+	while ( current < now ) {
+		current++;
+
+		// Cascade outer wheels whenever the inner one wraps around
+		for ( int level = 1; level < WHEEL_LEVELS; level++ ) {
+			if ( (current & ((1 << (WHEEL_BITS * level)) - 1)) != 0 ) {
+				break;
+			}
+			cascade(level);
+		}
+
+		int slot = current & (WHEEL_SLOTS - 1);
+		int index = heads[slot];
+		heads[slot] = -1;
+		while ( index != -1 ) {
+			Timer &t = timers[index];
+			int next = t.next;
+			if ( t.deadline <= current ) {
+				expired.push_back(t.key);
+				t.slot = -1;
+				freeTimers.push_back(index);
+				active--;
+			}
+			else {
+				// Parked timer that is still out of range
+				link(index);
+			}
+			index = next;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Returns the number of pending timers
+ */
+unsigned long TimingWheel::size() {
+	return active;
+}
+
+/**
+ * FUNCTION NAME: now
+ *
+ * DESCRIPTION: Returns the tick the wheel has advanced to
+ */
+int TimingWheel::now() {
+	return current;
+}
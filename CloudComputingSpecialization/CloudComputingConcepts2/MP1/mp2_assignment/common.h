@@ -2,14 +2,21 @@
 #define COMMON_H_
 
 /**
- * Global variable
+ * Types
  */
-// Transaction Id
-static int g_transID = 0;
+// Transaction id: node id, epoch and sequence of the coordinator, see PendingTable;
+// 0 marks a message no transaction waits on
+typedef long long TransID;
 
 // message types, reply is the message from node to coordinator
-enum MessageType {CREATE, READ, UPDATE, DELETE, REPLY, READREPLY};
+// hint is a write held for an unavailable replica, hintack confirms its replay
+// tree and treekeys carry Merkle tree hashes and the keys of differing leaves
+// digest is a read answered by digestreply with a hash of the value, and its version
+// batch carries one operation on many keys to a node, batchreply the result of each
+enum MessageType {CREATE, READ, UPDATE, DELETE, REPLY, READREPLY, HINT, HINTACK, TREE, TREEKEYS, DIGEST, DIGESTREPLY, BATCH, BATCHREPLY, SCAN, SCANREPLY, LOAD, LOADACK};
 // enum of replica types
 enum ReplicaType {PRIMARY, SECONDARY, TERTIARY};
+// replies a coordinator waits for: the first one, a majority or every replica
+enum ConsistencyLevel {ONE, QUORUM, ALL};
 
 #endif
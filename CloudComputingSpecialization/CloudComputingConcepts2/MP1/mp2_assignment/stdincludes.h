@@ -10,7 +10,6 @@
 /*
  * Macros
  */
-#define RING_SIZE 512
 #define FAILURE -1
 #define SUCCESS 0
 
@@ -18,6 +17,7 @@
  * Standard Header files
  */
 #include <stdio.h>
+#include <stddef.h>
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
@@ -31,6 +31,7 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <algorithm>
 #include <queue>